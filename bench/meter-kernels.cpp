@@ -0,0 +1,85 @@
+/**
+ *  Micro-benchmark of the meter kernels: measures every kernel supported by
+ *  the CPU on one second of 48 kHz audio per channel layout, and checks
+ *  their results against the scalar kernel.
+ *
+ *  Built with -DBUILD_BENCHMARKS=ON as the meter-kernels-bench target.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "meter-kernels.hpp"
+
+using namespace LinuxSoundMixer;
+
+#define RATE 48000
+#define ITERATIONS 200
+
+static bool sameLevels(const ChannelLevels &a, const ChannelLevels &b)
+{
+    for (uint8_t c = 0; c < a.channels; c++)
+    {
+        if (a.peak[c] != b.peak[c] || a.clipped[c] != b.clipped[c]
+            || std::fabs(a.rms[c] - b.rms[c]) > 1e-5F * (1.F + b.rms[c]))
+            return false;
+    }
+    return a.frames == b.frames;
+}
+
+static void bench(const char *label, const pa_sample_spec &spec,
+    const void *data, size_t length)
+{
+    ChannelLevels reference;
+    MeasureLevels(spec, data, length, &reference, KERNEL_SCALAR);
+
+    double scalarNs = 0;
+    for (int k = KERNEL_SCALAR; k <= BestMeterKernel(); k++)
+    {
+        MeterKernel kernel = (MeterKernel)k;
+        ChannelLevels levels;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; i++)
+            MeasureLevels(spec, data, length, &levels, kernel);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count()
+            / ((double)ITERATIONS * RATE * spec.channels);
+        if (kernel == KERNEL_SCALAR)
+            scalarNs = ns;
+        std::printf("%-12s %-7s %7.3f ns/sample  x%5.2f  %s\n", label,
+            MeterKernelName(kernel), ns, scalarNs / ns,
+            sameLevels(levels, reference) ? "ok" : "MISMATCH");
+    }
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> amplitude(-1.05F, 1.05F);
+
+    for (uint8_t channels : {1, 2, 6})
+    {
+        size_t count = (size_t)RATE * channels;
+        std::vector<float> floats(count);
+        std::vector<int16_t> shorts(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            floats[i] = amplitude(random);
+            float clamped = std::fmin(std::fmax(floats[i], -1.F), 1.F);
+            shorts[i] = (int16_t)std::lrint(clamped * 32767);
+        }
+
+        char label[32];
+        std::snprintf(label, sizeof(label), "f32 %uch", channels);
+        pa_sample_spec spec {PA_SAMPLE_FLOAT32NE, RATE, channels};
+        bench(label, spec, floats.data(), count * sizeof(float));
+
+        std::snprintf(label, sizeof(label), "s16 %uch", channels);
+        spec.format = PA_SAMPLE_S16NE;
+        bench(label, spec, shorts.data(), count * sizeof(int16_t));
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ *  Micro-benchmark of the spectrum analyser: feeds ten seconds of 48 kHz
+ *  mono audio through every kernel supported by the CPU for a few FFT
+ *  sizes, and checks the bands against the scalar kernel.
+ *
+ *  Built with -DBUILD_BENCHMARKS=ON as the spectrum-bench target.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "spectrum.hpp"
+
+using namespace LinuxSoundMixer;
+
+#define RATE 48000
+#define SECONDS 10
+#define BANDS 64
+
+static std::vector<float> lastBands(SpectrumAnalyser &analyser)
+{
+    auto ring = analyser.Ring();
+    const uint32_t *header = static_cast<const uint32_t *>(ring->Data());
+    const float *slots = reinterpret_cast<const float *>(header + 4);
+    const float *last = slots + ((header[1] - 1) % header[2]) * header[3];
+    return std::vector<float>(last, last + header[3]);
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> noise(-0.1F, 0.1F);
+    std::vector<float> samples((size_t)RATE * SECONDS);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = 0.5F * std::sin(2 * M_PI * 1000. * i / RATE)
+            + noise(random);
+
+    for (uint32_t size : {512, 2048, 8192})
+    {
+        std::vector<float> reference;
+        double scalarNs = 0;
+        for (int k = KERNEL_SCALAR; k <= BestMeterKernel(); k++)
+        {
+            MeterKernel kernel = (MeterKernel)k;
+            SpectrumAnalyser analyser(
+                size, size / 2, WINDOW_HANN, BANDS, RATE, 4, kernel);
+            auto start = std::chrono::steady_clock::now();
+            analyser.Feed(samples.data(), samples.size());
+            auto elapsed = std::chrono::steady_clock::now() - start;
+
+            double ns = std::chrono::duration<double, std::nano>(elapsed)
+                            .count()
+                / samples.size();
+            std::vector<float> bands = lastBands(analyser);
+            if (kernel == KERNEL_SCALAR)
+            {
+                scalarNs = ns;
+                reference = bands;
+            }
+            bool same = true;
+            for (size_t b = 0; b < bands.size(); b++)
+                same = same
+                    && std::fabs(bands[b] - reference[b])
+                        <= 1e-4F * (1.F + reference[b]);
+            std::printf("fft %-5u %-7s %7.3f ns/sample  x%5.2f  %s\n", size,
+                MeterKernelName(kernel), ns, scalarNs / ns,
+                same ? "ok" : "MISMATCH");
+        }
+    }
+
+    return 0;
+}
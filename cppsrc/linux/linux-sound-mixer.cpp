@@ -1,6 +1,11 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include "linux-sound-mixer.hpp"
+#include "meter-kernels.hpp"
+#include "volume-scale.hpp"
 
 #define WAIT(op, ml)                      \
     do                                    \
@@ -8,9 +13,152 @@
         pa_mainloop_iterate(ml, 1, NULL); \
     } while (pa_operation_get_state(op) != PA_OPERATION_DONE);
 
+using LinuxSoundMixer::ChannelVolumes;
+using SoundMixerUtils::Clock;
 using std::vector;
 
 #define MAX_VOLUME PA_VOLUME_NORM
+// readings per second of the meters run by silence detectors
+#define SILENCE_DETECTOR_RATE 10
+// period of the steps of the ducking ramps
+#define DUCK_TICK_MS 10
+// how long a written volume is stepped from without the server reporting
+// it, after which it is assumed to have been changed by another client
+#define WRITTEN_VOLUME_TTL_MS 1000
+
+/**
+ *  \brief      Moves every channel of a volume by delta while keeping the
+ *  proportions between the channels, clamped to [0, MAX_VOLUME] or to the
+ *  loudest channel when it is already above.
+ *
+ *  \remarks    delta is expressed in the current volume scale and applied to
+ *  the loudest channel.
+ */
+static void _step_cvolume(pa_cvolume *vol, float delta)
+{
+    using namespace LinuxSoundMixer;
+    if (GetVolumeScale() != VolumeScale::LINEAR)
+    {
+        float loudest = VolumeToScalar(pa_cvolume_max(vol));
+        pa_cvolume_scale(vol, VolumeFromScalar(loudest + delta));
+        return;
+    }
+
+    pa_volume_t step = (pa_volume_t)(std::fabs(delta) * MAX_VOLUME);
+    if (delta > 0)
+        pa_cvolume_inc_clamp(vol, step,
+            std::max((pa_volume_t)MAX_VOLUME, pa_cvolume_max(vol)));
+    else
+        pa_cvolume_dec(vol, step);
+}
+
+static ChannelVolumes _channel_volumes(
+    const pa_channel_map *map, const pa_cvolume *vol)
+{
+    ChannelVolumes result {};
+    result.channels = std::min(map->channels, vol->channels);
+    result.mapped = true;
+    for (uint8_t i = 0; i < result.channels; i++)
+    {
+        result.positions[i] = (uint8_t)map->map[i];
+        result.volumes[i] = LinuxSoundMixer::VolumeToScalar(vol->values[i]);
+    }
+
+    return result;
+}
+
+/**
+ *  \brief      Writes the given channel volumes into vol, matching them by
+ *  position through the channel map unless values is not mapped.
+ */
+static void _apply_channel_volumes(
+    const pa_channel_map *map, pa_cvolume *vol, const ChannelVolumes &values)
+{
+    for (uint8_t i = 0; i < values.channels && i < PA_CHANNELS_MAX; i++)
+    {
+        pa_volume_t volume
+            = LinuxSoundMixer::VolumeFromScalar(values.volumes[i]);
+        if (!values.mapped)
+        {
+            if (i < vol->channels)
+                vol->values[i] = volume;
+            continue;
+        }
+
+        for (uint8_t j = 0; j < map->channels && j < vol->channels; j++)
+        {
+            if ((uint8_t)map->map[j] == values.positions[i])
+                vol->values[j] = volume;
+        }
+    }
+}
+
+/**
+ *  \brief      Overwrites the channels of vol with raw volumes, clamped to
+ *  PA_VOLUME_MAX. A single value is applied to every channel, otherwise the
+ *  values are matched by channel index and extra channels are left as is.
+ */
+static void _apply_raw_volume(pa_cvolume *vol, const pa_cvolume &values)
+{
+    for (uint8_t i = 0; i < vol->channels; i++)
+    {
+        if (values.channels == 1)
+            vol->values[i] = PA_CLAMP_VOLUME(values.values[0]);
+        else if (i < values.channels)
+            vol->values[i] = PA_CLAMP_VOLUME(values.values[i]);
+    }
+}
+
+/**
+ *  \brief      Writes the volume of a device or session without waiting for
+ *  it.
+ *
+ *  \return     The operation, to be unreferenced by the caller.
+ */
+static pa_operation *_set_volume(
+    pa_context *ctx, Target target, const pa_cvolume *volume)
+{
+    bool output = target.type == DeviceType::OUTPUT;
+    if (target.kind == SoundMixerUtils::TARGET_DEVICE)
+        return output ? pa_context_set_sink_volume_by_index(
+                   ctx, target.index, volume, NULL, NULL)
+                      : pa_context_set_source_volume_by_index(
+                          ctx, target.index, volume, NULL, NULL);
+    return output ? pa_context_set_sink_input_volume(
+               ctx, target.index, volume, NULL, NULL)
+                  : pa_context_set_source_output_volume(
+                      ctx, target.index, volume, NULL, NULL);
+}
+
+void _count_success_cb(pa_context *ctx, int success, size_t *count)
+{
+    if (success)
+        (*count)++;
+}
+
+static pa_operation *_set_mute(pa_context *ctx, Target target, int mute)
+{
+    bool output = target.type == DeviceType::OUTPUT;
+    if (target.kind == SoundMixerUtils::TARGET_DEVICE)
+        return output ? pa_context_set_sink_mute_by_index(
+                   ctx, target.index, mute, NULL, NULL)
+                      : pa_context_set_source_mute_by_index(
+                          ctx, target.index, mute, NULL, NULL);
+    return output
+        ? pa_context_set_sink_input_mute(ctx, target.index, mute, NULL, NULL)
+        : pa_context_set_source_output_mute(
+            ctx, target.index, mute, NULL, NULL);
+}
+
+static pa_operation *_move_session(
+    pa_context *ctx, Target target, uint32_t device, size_t *moved)
+{
+    if (target.type == DeviceType::OUTPUT)
+        return pa_context_move_sink_input_by_index(ctx, target.index, device,
+            (pa_context_success_cb_t)_count_success_cb, moved);
+    return pa_context_move_source_output_by_index(ctx, target.index, device,
+        (pa_context_success_cb_t)_count_success_cb, moved);
+}
 
 // SoundMixer definition
 namespace LinuxSoundMixer
@@ -33,7 +181,8 @@ void state_cb(pa_context *ctx, int *ready)
     }
 }
 
-SoundMixer::SoundMixer()
+SoundMixer::SoundMixer(
+    on_device_changed_cb_t deviceCb, on_session_changed_cb_t sessionCb)
 {
     pa_mainloop *ml = pa_mainloop_new();
     pa_mainloop_api *api = pa_mainloop_get_api(ml);
@@ -42,6 +191,7 @@ SoundMixer::SoundMixer()
         ml,
         api,
         ctx,
+        NULL,
     };
 
     if (pa_context_connect(ctx, NULL, PA_CONTEXT_NOFLAGS, NULL) <= 0)
@@ -56,17 +206,47 @@ SoundMixer::SoundMixer()
     {
         pa_mainloop_iterate(ml, 1, NULL);
     }
+
+    if (deviceCb != NULL && sessionCb != NULL)
+    {
+        monitor = new EventMonitor(deviceCb, sessionCb);
+        pa.monitor = monitor;
+    }
 }
 
 SoundMixer::~SoundMixer()
 {
+    delete monitor;
     pa_context_disconnect(pa.ctx);
     pa_context_unref(pa.ctx);
     pa_mainloop_free(pa.mainloop);
 }
 
+void _server_info_cb(
+    pa_context *ctx, const pa_server_info *info, std::string *defaults)
+{
+    if (info->default_sink_name != NULL)
+        defaults[0] = info->default_sink_name;
+    if (info->default_source_name != NULL)
+        defaults[1] = info->default_source_name;
+}
+
 _Device *SoundMixer::GetDefaultDevice(DeviceType type)
 {
+    std::string defaults[2];
+    pa_operation *op = pa_context_get_server_info(
+        pa.ctx, (pa_server_info_cb_t)_server_info_cb, defaults);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    std::string name = defaults[type == DeviceType::OUTPUT ? 0 : 1];
+    _Device *device = name.empty() ? nullptr : GetDeviceByName(name, type);
+    if (device != nullptr)
+    {
+        return device;
+    }
+
+    // without a default, the first device of the type
     for (_Device *dev : GetDevices())
     {
         if (dev->type() == type)
@@ -159,24 +339,1735 @@ _Device *SoundMixer::GetDeviceByName(std::string name, DeviceType type)
     return nullptr;
 }
 
+_Device *SoundMixer::GetDeviceByIndex(uint32_t index, DeviceType type)
+{
+    vector<_Device *> result;
+    GetDevicesData data {
+        pa,
+        &result,
+    };
+    pa_operation *op;
+    if (type == DeviceType::INPUT)
+    {
+        op = pa_context_get_source_info_by_index(pa.ctx, index,
+            (pa_source_info_cb_t)_get_output_devices_cb, &data);
+    }
+    else
+    {
+        op = pa_context_get_sink_info_by_index(pa.ctx, index,
+            (pa_sink_info_cb_t)_get_input_devices_cb, &data);
+    }
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    if (result.size() > 0)
+    {
+        return result.at(0);
+    }
+    return nullptr;
+}
+
+typedef struct
+{
+    _PAControls controls;
+    _AudioSession *session;
+} GetSessionData;
+
+void _get_input_session_cb(
+    pa_context *ctx, pa_sink_input_info *info, int eol, GetSessionData *data)
+{
+    if (eol)
+    {
+        return;
+    }
+    data->session = new OutputAudioSession(data->controls, info->index);
+}
+
+void _get_output_session_cb(pa_context *ctx, pa_source_output_info *info,
+    int eol, GetSessionData *data)
+{
+    if (eol)
+    {
+        return;
+    }
+    data->session = new InputAudioSession(data->controls, info->index);
+}
+
+_AudioSession *SoundMixer::GetAudioSessionByIndex(
+    uint32_t index, DeviceType type)
+{
+    GetSessionData data {pa, nullptr};
+    pa_operation *op;
+    if (type == DeviceType::INPUT)
+    {
+        op = pa_context_get_source_output_info(pa.ctx, index,
+            (pa_source_output_info_cb_t)_get_output_session_cb, &data);
+    }
+    else
+    {
+        op = pa_context_get_sink_input_info(pa.ctx, index,
+            (pa_sink_input_info_cb_t)_get_input_session_cb, &data);
+    }
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    return data.session;
+}
+
+_AudioSession *SoundMixer::GetKnownAudioSession(
+    uint32_t index, DeviceType type)
+{
+    Subject subject;
+    int facility = type == DeviceType::INPUT
+        ? PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT
+        : PA_SUBSCRIPTION_EVENT_SINK_INPUT;
+    if (monitor == NULL || !monitor->LatestSubject(facility, index, &subject))
+        return GetAudioSessionByIndex(index, type);
+
+    if (type == DeviceType::INPUT)
+        return new InputAudioSession(pa, index);
+    return new OutputAudioSession(pa, index);
+}
+
+template <typename T>
+void _volume_state_cb(
+    pa_context *ctx, const T *info, int eol, VolumeState *state)
+{
+    if (eol)
+    {
+        return;
+    }
+
+    state->volume = info->volume;
+    state->mute = !!info->mute;
+    state->found = true;
+}
+
+/**
+ *  \brief      Waits for every operation, which were all sent beforehand so
+ *  that they share a round trip, then unreferences them.
+ */
+static void _wait_all(pa_mainloop *ml, const vector<pa_operation *> &ops)
+{
+    for (pa_operation *op : ops)
+    {
+        if (op == NULL)
+            continue;
+        WAIT(op, ml);
+        pa_operation_unref(op);
+    }
+}
+
+void _sink_input_target_cb(pa_context *ctx, pa_sink_input_info *info,
+    int eol, vector<Target> *targets)
+{
+    if (eol)
+        return;
+    targets->push_back(Target {
+        SoundMixerUtils::TARGET_SESSION, DeviceType::OUTPUT, info->index});
+}
+
+void _source_output_target_cb(pa_context *ctx, pa_source_output_info *info,
+    int eol, vector<Target> *targets)
+{
+    if (eol)
+        return;
+    targets->push_back(Target {
+        SoundMixerUtils::TARGET_SESSION, DeviceType::INPUT, info->index});
+}
+
+/**
+ *  \brief      Lists every sink input, or every source output, through the
+ *  main context, for when there is no EventMonitor holding the sessions.
+ */
+static vector<Target> _list_sessions(const _PAControls &pa, DeviceType type)
+{
+    vector<Target> targets;
+    pa_operation *op = type == DeviceType::OUTPUT
+        ? pa_context_get_sink_input_info_list(pa.ctx,
+            (pa_sink_input_info_cb_t)_sink_input_target_cb, &targets)
+        : pa_context_get_source_output_info_list(pa.ctx,
+            (pa_source_output_info_cb_t)_source_output_target_cb, &targets);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    return targets;
+}
+
+vector<VolumeState> SoundMixer::GetVolumeStates(
+    const vector<Target> &targets)
+{
+    vector<VolumeState> states(targets.size(), VolumeState {});
+    vector<pa_operation *> ops;
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        uint32_t index = targets[i].index;
+        bool output = targets[i].type == DeviceType::OUTPUT;
+        VolumeState *state = &states[i];
+        if (targets[i].kind == SoundMixerUtils::TARGET_DEVICE && output)
+            ops.push_back(pa_context_get_sink_info_by_index(pa.ctx, index,
+                (pa_sink_info_cb_t)_volume_state_cb<pa_sink_info>, state));
+        else if (targets[i].kind == SoundMixerUtils::TARGET_DEVICE)
+            ops.push_back(pa_context_get_source_info_by_index(pa.ctx, index,
+                (pa_source_info_cb_t)_volume_state_cb<pa_source_info>,
+                state));
+        else if (output)
+            ops.push_back(pa_context_get_sink_input_info(pa.ctx, index,
+                (pa_sink_input_info_cb_t)
+                    _volume_state_cb<pa_sink_input_info>,
+                state));
+        else
+            ops.push_back(pa_context_get_source_output_info(pa.ctx, index,
+                (pa_source_output_info_cb_t)
+                    _volume_state_cb<pa_source_output_info>,
+                state));
+    }
+    _wait_all(pa.mainloop, ops);
+
+    return states;
+}
+
+void SoundMixer::SetVolumes(
+    const vector<Target> &targets, const vector<pa_cvolume> &volumes)
+{
+    vector<pa_operation *> ops;
+    for (size_t i = 0; i < targets.size() && i < volumes.size(); i++)
+    {
+        if (volumes[i].channels > 0)
+            ops.push_back(_set_volume(pa.ctx, targets[i], &volumes[i]));
+    }
+    _wait_all(pa.mainloop, ops);
+}
+
+void SoundMixer::SetMutes(const vector<Target> &targets, bool mute)
+{
+    vector<pa_operation *> ops;
+    for (const Target &target : targets)
+    {
+        ops.push_back(_set_mute(pa.ctx, target, (int)mute));
+    }
+    _wait_all(pa.mainloop, ops);
+}
+
+bool SoundMixer::SetDefaultDevice(_Device *device, bool moveSessions)
+{
+    std::string name = device->name();
+    size_t done = 0;
+    vector<pa_operation *> ops;
+    if (device->type() == DeviceType::OUTPUT)
+        ops.push_back(pa_context_set_default_sink(pa.ctx, name.c_str(),
+            (pa_context_success_cb_t)_count_success_cb, &done));
+    else
+        ops.push_back(pa_context_set_default_source(pa.ctx, name.c_str(),
+            (pa_context_success_cb_t)_count_success_cb, &done));
+
+    // the moves share the round trip of the new default, only listing the
+    // sessions costs one more without the monitor
+    size_t moved = 0;
+    Selector selector {SoundMixerUtils::TARGET_SESSION, (int)device->type(),
+        Matcher(), Matcher(), Matcher()};
+    vector<Target> sessions;
+    if (moveSessions && monitor != NULL)
+        sessions = FindSessions(selector);
+    else if (moveSessions)
+        sessions = _list_sessions(pa, device->type());
+    for (const Target &session : sessions)
+    {
+        ops.push_back(
+            _move_session(pa.ctx, session, device->index, &moved));
+    }
+    _wait_all(pa.mainloop, ops);
+
+    return done > 0 && moved == sessions.size();
+}
+
+size_t SoundMixer::MoveSessions(
+    const vector<Target> &sessions, uint32_t device)
+{
+    size_t moved = 0;
+    vector<pa_operation *> ops;
+    for (const Target &session : sessions)
+    {
+        ops.push_back(_move_session(pa.ctx, session, device, &moved));
+    }
+    _wait_all(pa.mainloop, ops);
+
+    return moved;
+}
+
+vector<Target> SoundMixer::FindSessions(const Selector &selector)
+{
+    if (monitor == NULL)
+        return vector<Target>();
+    return monitor->FindSessions(selector);
+}
+
+bool SoundMixer::UploadSample(const std::string &name,
+    const pa_sample_spec &spec, const void *data, size_t length)
+{
+    pa_stream *stream = pa_stream_new(pa.ctx, name.c_str(), &spec, NULL);
+    if (stream == NULL)
+        return false;
+
+    bool uploaded = false;
+    if (pa_stream_connect_upload(stream, length) >= 0)
+    {
+        pa_stream_state_t state;
+        while ((state = pa_stream_get_state(stream)) == PA_STREAM_CREATING)
+            pa_mainloop_iterate(pa.mainloop, 1, NULL);
+
+        // the whole sample is written at once, the server storing it when
+        // the upload is finished
+        if (state == PA_STREAM_READY
+            && pa_stream_write(
+                   stream, data, length, NULL, 0, PA_SEEK_RELATIVE)
+                >= 0
+            && pa_stream_finish_upload(stream) >= 0)
+        {
+            while ((state = pa_stream_get_state(stream)) == PA_STREAM_READY)
+                pa_mainloop_iterate(pa.mainloop, 1, NULL);
+            uploaded = state == PA_STREAM_TERMINATED;
+        }
+    }
+    pa_stream_unref(stream);
+
+    return uploaded;
+}
+
+bool SoundMixer::RemoveSample(const std::string &name)
+{
+    size_t removed = 0;
+    pa_operation *op = pa_context_remove_sample(pa.ctx, name.c_str(),
+        (pa_context_success_cb_t)_count_success_cb, &removed);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    return removed > 0;
+}
+
+bool SoundMixer::SetRules(const std::vector<SessionRule> &rules)
+{
+    if (monitor == NULL)
+        return false;
+    monitor->SetRules(rules);
+    return true;
+}
+
+int SoundMixer::StartDucking(const Selector &trigger, const Selector &target,
+    double depth, uint32_t attackMs, uint32_t releaseMs)
+{
+    if (monitor == NULL)
+        return -1;
+    return monitor->StartDucking(
+        trigger, target, depth, attackMs, releaseMs);
+}
+
+bool SoundMixer::StopDucking(int id)
+{
+    return monitor != NULL && monitor->StopDucking(id);
+}
+
 } // namespace LinuxSoundMixer
 
-// definition for Device
+// EventMonitor
 namespace LinuxSoundMixer
 {
 
-_Device::_Device(_PAControls controls, uint32_t index) : index(index)
+#define STATE_KEY(type, index) (((uint64_t)(type) << 32) | (index))
+
+void _monitor_state_cb(pa_context *ctx, EventMonitor *monitor)
 {
-    pa = controls;
+    monitor->OnStateChange();
 }
 
-_Device::~_Device()
+void _monitor_subscribe_cb(pa_context *ctx, pa_subscription_event_type_t type,
+    uint32_t index, EventMonitor *monitor)
+{
+    monitor->OnEvent(type, index);
+}
+
+void _monitor_sink_info_cb(
+    pa_context *ctx, pa_sink_info *info, int eol, EventMonitor *monitor)
+{
+    if (eol)
+    {
+        return;
+    }
+
+    DeviceDescriptor desc {info->name, info->name, DeviceType::OUTPUT};
+    if (pa_proplist_contains(info->proplist, PA_PROP_DEVICE_DESCRIPTION))
+    {
+        desc.id = pa_proplist_gets(info->proplist, PA_PROP_DEVICE_DESCRIPTION);
+    }
+    monitor->OnDeviceInfo(desc, info->index, &info->volume, info->mute);
+}
+
+void _monitor_source_info_cb(
+    pa_context *ctx, pa_source_info *info, int eol, EventMonitor *monitor)
+{
+    if (eol)
+    {
+        return;
+    }
+
+    DeviceDescriptor desc {info->name, info->name, DeviceType::INPUT};
+    monitor->OnDeviceInfo(desc, info->index, &info->volume, info->mute);
+}
+
+Subject _session_subject(
+    DeviceType type, uint32_t index, const char *name, pa_proplist *props)
+{
+    Subject subject;
+    subject.target = Target {SoundMixerUtils::TARGET_SESSION, type, index};
+    subject.name = name != NULL ? name : "";
+    subject.appName = subject.name;
+    if (pa_proplist_contains(props, PA_PROP_APPLICATION_NAME))
+    {
+        subject.appName = pa_proplist_gets(props, PA_PROP_APPLICATION_NAME);
+    }
+    return subject;
+}
+
+void _monitor_sink_input_info_cb(pa_context *ctx, pa_sink_input_info *info,
+    int eol, EventMonitor *monitor)
+{
+    if (eol)
+    {
+        return;
+    }
+
+    Subject subject = _session_subject(
+        DeviceType::OUTPUT, info->index, info->name, info->proplist);
+    monitor->ApplyRules(
+        subject, info->proplist, &info->volume, &info->mute);
+    monitor->OnSessionInfo(
+        subject, info->sink, &info->volume, info->mute, info->corked);
+}
+
+void _monitor_source_output_info_cb(pa_context *ctx,
+    pa_source_output_info *info, int eol, EventMonitor *monitor)
+{
+    if (eol)
+    {
+        return;
+    }
+
+    Subject subject = _session_subject(
+        DeviceType::INPUT, info->index, info->name, info->proplist);
+    monitor->ApplyRules(
+        subject, info->proplist, &info->volume, &info->mute);
+    monitor->OnSessionInfo(
+        subject, info->source, &info->volume, info->mute, info->corked);
+}
+
+void _duck_timer_cb(pa_mainloop_api *api, pa_time_event *event,
+    const struct timeval *tv, EventMonitor *monitor)
+{
+    monitor->OnDuckTimer();
+}
+
+/**
+ *  \brief      The facility of the objects designated by a target, which
+ *  with the target index forms the keys of the monitor state.
+ */
+static int _target_facility(Target target)
+{
+    bool output = target.type == DeviceType::OUTPUT;
+    if (target.kind == SoundMixerUtils::TARGET_SESSION)
+        return output ? PA_SUBSCRIPTION_EVENT_SINK_INPUT
+                      : PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT;
+    return output ? PA_SUBSCRIPTION_EVENT_SINK : PA_SUBSCRIPTION_EVENT_SOURCE;
+}
+
+void _meter_read_cb(pa_stream *stream, size_t length, _Meter *meter)
 {
+    // every queued fragment is drained so that readings never lag behind,
+    // with PA_STREAM_PEAK_DETECT each sample being the peak of an interval
+    const void *data;
+    bool measured = false;
+    float peak = 0.F;
+    while (pa_stream_peek(stream, &data, &length) >= 0 && length > 0)
+    {
+        // holes are skipped
+        if (data != NULL)
+        {
+            ChannelLevels levels {};
+            MeasureLevels(
+                *pa_stream_get_sample_spec(stream), data, length, &levels);
+            peak = std::max(peak, levels.peak[0]);
+            measured = true;
+        }
+        pa_stream_drop(stream);
+    }
+
+    if (measured)
+        meter->monitor->OnPeak(meter, std::min(peak, 1.F));
 }
 
-DeviceDescriptor _Device::ToDeviceDescriptor()
-{
-    return DeviceDescriptor {name(), friendlyName(), type()};
+void _capture_read_cb(pa_stream *stream, size_t length, _Capture *capture)
+{
+    const void *data;
+    while (pa_stream_peek(stream, &data, &length) >= 0 && length > 0)
+    {
+        // holes are skipped
+        if (data != NULL)
+            capture->callback(capture->userdata, data, length);
+        pa_stream_drop(stream);
+    }
+}
+
+void _loudness_read_cb(pa_stream *stream, size_t length, _Loudness *loudness)
+{
+    const void *data;
+    while (pa_stream_peek(stream, &data, &length) >= 0 && length > 0)
+    {
+        if (data == NULL)
+        {
+            pa_stream_drop(stream);
+            continue;
+        }
+
+        const pa_sample_spec *spec = pa_stream_get_sample_spec(stream);
+        if (loudness->meter == NULL)
+        {
+            loudness->meter = new LoudnessMeter(
+                *spec, pa_stream_get_channel_map(stream));
+            loudness->interval = std::max(
+                (uint32_t)((uint64_t)spec->rate * loudness->intervalMs
+                    / 1000),
+                1U);
+        }
+
+        // reports are sent on the exact frame their interval ends with
+        const float *samples = static_cast<const float *>(data);
+        size_t frames = length / pa_frame_size(spec);
+        while (frames > 0)
+        {
+            size_t taken = std::min(
+                frames, (size_t)(loudness->interval - loudness->pending));
+            loudness->meter->Feed(samples, taken);
+            ChannelLevels levels {};
+            MeasureLevels(*spec, samples, taken * pa_frame_size(spec),
+                &levels);
+            for (uint8_t c = 0; c < levels.channels; c++)
+                loudness->peak = std::max(loudness->peak, levels.peak[c]);
+            samples += taken * spec->channels;
+            frames -= taken;
+            loudness->pending += (uint32_t)taken;
+            if (loudness->pending == loudness->interval)
+            {
+                loudness->pending = 0;
+                loudness->monitor->OnLoudness(loudness);
+            }
+        }
+        pa_stream_drop(stream);
+    }
+}
+
+void _capture_state_cb(pa_stream *stream, _Capture *capture)
+{
+    switch (pa_stream_get_state(stream))
+    {
+        case PA_STREAM_FAILED:
+        case PA_STREAM_TERMINATED:
+            if (!capture->ended)
+            {
+                capture->ended = true;
+                capture->callback(capture->userdata, NULL, 0);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+EventMonitor::EventMonitor(
+    on_device_changed_cb_t deviceCb, on_session_changed_cb_t sessionCb)
+    : deviceCallback(deviceCb), sessionCallback(sessionCb)
+{
+    mainloop = pa_threaded_mainloop_new();
+    ctx = pa_context_new(
+        pa_threaded_mainloop_get_api(mainloop), "sound-mixer-events");
+    pa_context_set_state_callback(
+        ctx, (pa_context_notify_cb_t)_monitor_state_cb, this);
+
+    pa_threaded_mainloop_lock(mainloop);
+    if (pa_context_connect(ctx, NULL, PA_CONTEXT_NOFLAGS, NULL) < 0
+        || pa_threaded_mainloop_start(mainloop) < 0)
+    {
+        ready = -1;
+    }
+
+    while (ready == 0)
+    {
+        pa_threaded_mainloop_wait(mainloop);
+    }
+
+    if (ready > 0)
+    {
+        pa_context_set_subscribe_callback(
+            ctx, (pa_context_subscribe_cb_t)_monitor_subscribe_cb, this);
+        pa_operation *op = pa_context_subscribe(ctx,
+            (pa_subscription_mask_t)(PA_SUBSCRIPTION_MASK_SINK
+                | PA_SUBSCRIPTION_MASK_SOURCE
+                | PA_SUBSCRIPTION_MASK_SINK_INPUT
+                | PA_SUBSCRIPTION_MASK_SOURCE_OUTPUT),
+            NULL, NULL);
+        if (op != NULL)
+            pa_operation_unref(op);
+
+        // fills the state cache, no notification is sent for known objects.
+        // devices are listed first so that sessions can resolve their device.
+        pa_operation *ops[] = {
+            pa_context_get_sink_info_list(
+                ctx, (pa_sink_info_cb_t)_monitor_sink_info_cb, this),
+            pa_context_get_source_info_list(
+                ctx, (pa_source_info_cb_t)_monitor_source_info_cb, this),
+            pa_context_get_sink_input_info_list(ctx,
+                (pa_sink_input_info_cb_t)_monitor_sink_input_info_cb, this),
+            pa_context_get_source_output_info_list(ctx,
+                (pa_source_output_info_cb_t)_monitor_source_output_info_cb,
+                this),
+        };
+        for (pa_operation *o : ops)
+        {
+            if (o != NULL)
+                pa_operation_unref(o);
+        }
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+EventMonitor::~EventMonitor()
+{
+    pa_threaded_mainloop_lock(mainloop);
+    if (duckTimer != NULL)
+        pa_threaded_mainloop_get_api(mainloop)->time_free(duckTimer);
+    for (auto &ducker : duckers)
+    {
+        for (auto &ducked : ducker.second.sessions)
+        {
+            if (ducked.second.op != NULL)
+                pa_operation_unref(ducked.second.op);
+        }
+    }
+    while (!meters.empty())
+    {
+        ReleaseMeter(meters.begin()->first);
+    }
+    while (!loudnessMeters.empty())
+    {
+        ReleaseLoudness(loudnessMeters.begin()->first);
+    }
+    for (_Capture *capture : captures)
+    {
+        ReleaseCapture(capture);
+    }
+    captures.clear();
+    pa_context_disconnect(ctx);
+    pa_threaded_mainloop_unlock(mainloop);
+
+    pa_threaded_mainloop_stop(mainloop);
+    pa_context_unref(ctx);
+    pa_threaded_mainloop_free(mainloop);
+}
+
+void EventMonitor::OnStateChange()
+{
+    switch (pa_context_get_state(ctx))
+    {
+        case PA_CONTEXT_READY:
+            ready = 1;
+            break;
+        case PA_CONTEXT_FAILED:
+        case PA_CONTEXT_TERMINATED:
+            ready = -1;
+            break;
+        default:
+            return;
+    }
+    pa_threaded_mainloop_signal(mainloop, 0);
+}
+
+void EventMonitor::OnEvent(pa_subscription_event_type_t type, uint32_t index)
+{
+    int facility = type & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+    uint64_t key = STATE_KEY(facility, index);
+    if ((type & PA_SUBSCRIPTION_EVENT_TYPE_MASK)
+        == PA_SUBSCRIPTION_EVENT_REMOVE)
+    {
+        created.erase(key);
+        limits.erase(key);
+        written.erase(key);
+        NotificationHandler removed {DEVICE_CHANGE_MASK_REMOVED, 0.F, false,
+            Target {}, 0.F, 0.F, 0.F, 0.F, false};
+        auto device = devices.find(key);
+        if (device != devices.end())
+        {
+            removed.target = Target {SoundMixerUtils::TARGET_DEVICE,
+                device->second.desc.type, index};
+            deviceCallback(device->second.desc, removed);
+            devices.erase(device);
+            ReleaseMeter(key);
+            ReleaseLoudness(key);
+        }
+        auto session = sessions.find(key);
+        if (session != sessions.end())
+        {
+            removed.target = session->second.subject.target;
+            sessionCallback(session->second.subject, removed);
+            sessions.erase(session);
+            ReleaseMeter(key);
+            ReleaseLoudness(key);
+            for (auto &ducker : duckers)
+            {
+                auto ducked = ducker.second.sessions.find(key);
+                if (ducked == ducker.second.sessions.end())
+                    continue;
+                if (ducked->second.op != NULL)
+                    pa_operation_unref(ducked->second.op);
+                ducker.second.sessions.erase(ducked);
+            }
+            UpdateDucking();
+        }
+        return;
+    }
+
+    bool session = facility == PA_SUBSCRIPTION_EVENT_SINK_INPUT
+        || facility == PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT;
+    if (session
+        && (type & PA_SUBSCRIPTION_EVENT_TYPE_MASK)
+            == PA_SUBSCRIPTION_EVENT_NEW)
+    {
+        created.insert(key);
+    }
+
+    pa_operation *op;
+    switch (facility)
+    {
+        case PA_SUBSCRIPTION_EVENT_SINK:
+            op = pa_context_get_sink_info_by_index(
+                ctx, index, (pa_sink_info_cb_t)_monitor_sink_info_cb, this);
+            break;
+        case PA_SUBSCRIPTION_EVENT_SOURCE:
+            op = pa_context_get_source_info_by_index(ctx, index,
+                (pa_source_info_cb_t)_monitor_source_info_cb, this);
+            break;
+        case PA_SUBSCRIPTION_EVENT_SINK_INPUT:
+            op = pa_context_get_sink_input_info(ctx, index,
+                (pa_sink_input_info_cb_t)_monitor_sink_input_info_cb, this);
+            break;
+        case PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT:
+            op = pa_context_get_source_output_info(ctx, index,
+                (pa_source_output_info_cb_t)_monitor_source_output_info_cb,
+                this);
+            break;
+        default:
+            return;
+    }
+    if (op != NULL)
+        pa_operation_unref(op);
+}
+
+void EventMonitor::OnDeviceInfo(DeviceDescriptor desc, uint32_t index,
+    const pa_cvolume *volume, int mute)
+{
+    int facility = desc.type == DeviceType::OUTPUT
+        ? PA_SUBSCRIPTION_EVENT_SINK
+        : PA_SUBSCRIPTION_EVENT_SOURCE;
+    _DeviceState state {
+        VolumeToScalar(pa_cvolume_avg(volume)), !!mute, desc, *volume};
+    uint64_t key = STATE_KEY(facility, index);
+    Target target {SoundMixerUtils::TARGET_DEVICE, desc.type, index};
+    bool clamped = EnforceLimit(key, target, volume);
+    ForgetWritten(key, volume);
+
+    auto found = devices.find(key);
+    if (found == devices.end())
+    {
+        devices[key] = state;
+        return;
+    }
+
+    int flags = 0;
+    if (found->second.mute != state.mute)
+        flags |= DEVICE_CHANGE_MASK_MUTE;
+    // compared raw, the scalars depend on the current scale
+    if (!pa_cvolume_equal(&found->second.cvolume, volume) && !clamped)
+        flags |= DEVICE_CHANGE_MASK_VOLUME;
+    found->second = state;
+
+    if (flags != 0)
+    {
+        deviceCallback(desc,
+            NotificationHandler {flags, state.volume, state.mute, target,
+                0.F, 0.F, 0.F, 0.F, false});
+    }
+}
+
+void EventMonitor::OnSessionInfo(Subject subject, uint32_t deviceIndex,
+    const pa_cvolume *volume, int mute, int corked)
+{
+    bool output = subject.target.type == DeviceType::OUTPUT;
+    auto device = devices.find(STATE_KEY(
+        output ? PA_SUBSCRIPTION_EVENT_SINK : PA_SUBSCRIPTION_EVENT_SOURCE,
+        deviceIndex));
+    if (device != devices.end())
+    {
+        subject.device = device->second.desc.id;
+    }
+
+    uint64_t key = STATE_KEY(output ? PA_SUBSCRIPTION_EVENT_SINK_INPUT
+                                    : PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT,
+        subject.target.index);
+    _SessionState state {VolumeToScalar(pa_cvolume_avg(volume)), !!mute,
+        subject, *volume, !!corked, !corked};
+    bool clamped = EnforceLimit(key, subject.target, volume);
+    bool ducked = DuckingWrote(key, volume);
+    ForgetWritten(key, volume);
+
+    auto found = sessions.find(key);
+    if (found == sessions.end())
+    {
+        sessions[key] = state;
+        UpdateDucking();
+        return;
+    }
+
+    int flags = 0;
+    if (found->second.mute != state.mute)
+        flags |= DEVICE_CHANGE_MASK_MUTE;
+    // compared raw, the scalars depend on the current scale
+    if (!pa_cvolume_equal(&found->second.cvolume, volume) && !clamped
+        && !ducked)
+        flags |= DEVICE_CHANGE_MASK_VOLUME;
+    bool uncorked = found->second.corked != state.corked;
+    state.active = found->second.active;
+    found->second = state;
+
+    if (flags & DEVICE_CHANGE_MASK_VOLUME)
+        RebaseDucked(key, volume);
+    if (flags != 0)
+    {
+        sessionCallback(subject,
+            NotificationHandler {flags, state.volume, state.mute,
+                subject.target, 0.F, 0.F, 0.F, 0.F, false});
+    }
+    if (uncorked)
+        UpdateActivity(key);
+}
+
+/**
+ *  \brief      Applies the first rule matching a stream, if the stream has
+ *  just been created. Its volume is only written when the rule changes it.
+ *
+ *  \remarks    volume and mute are updated to the values written, which the
+ *  state cache then holds instead of the initial ones.
+ */
+void EventMonitor::ApplyRules(const Subject &subject, pa_proplist *props,
+    pa_cvolume *volume, int *mute)
+{
+    bool output = subject.target.type == DeviceType::OUTPUT;
+    uint64_t key = STATE_KEY(output ? PA_SUBSCRIPTION_EVENT_SINK_INPUT
+                                    : PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT,
+        subject.target.index);
+    // the streams listed on startup are left alone
+    if (created.erase(key) == 0 || rules.empty())
+        return;
+
+    const char *binary
+        = pa_proplist_gets(props, PA_PROP_APPLICATION_PROCESS_BINARY);
+    const char *role = pa_proplist_gets(props, PA_PROP_MEDIA_ROLE);
+    const SessionRule *rule = NULL;
+    for (const SessionRule &r : rules)
+    {
+        if ((r.type < 0 || r.type == (int)subject.target.type)
+            && r.appName.Match(subject.appName)
+            && r.binary.Match(binary != NULL ? binary : "")
+            && r.role.Match(role != NULL ? role : ""))
+        {
+            rule = &r;
+            break;
+        }
+    }
+    if (rule == NULL)
+        return;
+
+    pa_cvolume vol = *volume;
+    if (rule->volume != PA_VOLUME_INVALID)
+        pa_cvolume_set(&vol, vol.channels, rule->volume);
+    // scaled down as a whole, keeping the balance, and kept below
+    if (rule->maxVolume != PA_VOLUME_INVALID)
+    {
+        limits[key] = rule->maxVolume;
+        if (pa_cvolume_max(&vol) > rule->maxVolume)
+            pa_cvolume_scale(&vol, rule->maxVolume);
+    }
+
+    pa_operation *ops[2] = {NULL, NULL};
+    if (!pa_cvolume_equal(&vol, volume))
+    {
+        ops[0] = _set_volume(ctx, subject.target, &vol);
+        *volume = vol;
+    }
+    if (rule->mute >= 0)
+    {
+        ops[1] = _set_mute(ctx, subject.target, rule->mute);
+        *mute = rule->mute;
+    }
+    for (pa_operation *op : ops)
+    {
+        if (op != NULL)
+            pa_operation_unref(op);
+    }
+}
+
+void EventMonitor::SetRules(const std::vector<SessionRule> &values)
+{
+    pa_threaded_mainloop_lock(mainloop);
+    rules = values;
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+/**
+ *  \brief      Recomputes whether a session is active, from its corked flag
+ *  and its silence detector, and reports it if it changed.
+ */
+void EventMonitor::UpdateActivity(uint64_t key)
+{
+    auto session = sessions.find(key);
+    if (session == sessions.end())
+        return;
+
+    _SessionState &state = session->second;
+    bool active = !state.corked;
+    auto meter = meters.find(key);
+    if (active && meter != meters.end() && meter->second.detectors > 0)
+    {
+        _Meter &detector = meter->second;
+        active = Clock::now() - detector.lastSignal < detector.hold;
+    }
+    if (active == state.active)
+        return;
+
+    state.active = active;
+    NotificationHandler data {DEVICE_CHANGE_MASK_ACTIVE, state.volume,
+        state.mute, state.subject.target, 0.F, 0.F, 0.F, 0.F, active};
+    sessionCallback(state.subject, data);
+    UpdateDucking();
+}
+
+/**
+ *  \brief      Scales a volume above the limit of its object back down.
+ *
+ *  \return     true if the volume violated the limit.
+ */
+bool EventMonitor::EnforceLimit(
+    uint64_t key, Target target, const pa_cvolume *volume)
+{
+    auto limit = limits.find(key);
+    if (limit == limits.end() || pa_cvolume_max(volume) <= limit->second)
+        return false;
+
+    pa_cvolume vol = *volume;
+    pa_cvolume_scale(&vol, limit->second);
+    pa_operation *op = _set_volume(ctx, target, &vol);
+    if (op != NULL)
+        pa_operation_unref(op);
+    return true;
+}
+
+void EventMonitor::SetMaxVolume(Target target, pa_volume_t max)
+{
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+
+    pa_threaded_mainloop_lock(mainloop);
+    if (max == PA_VOLUME_INVALID)
+        limits.erase(key);
+    else
+        limits[key] = max;
+
+    auto device = devices.find(key);
+    auto session = sessions.find(key);
+    if (device != devices.end())
+        EnforceLimit(key, target, &device->second.cvolume);
+    else if (session != sessions.end())
+        EnforceLimit(key, target, &session->second.cvolume);
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+vector<Target> EventMonitor::FindSessions(const Selector &selector)
+{
+    vector<Target> result;
+
+    pa_threaded_mainloop_lock(mainloop);
+    for (auto &session : sessions)
+    {
+        if (selectorMatches(selector, session.second.subject))
+            result.push_back(session.second.subject.target);
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return result;
+}
+
+int EventMonitor::StartDucking(const Selector &trigger,
+    const Selector &target, double depth, uint32_t attackMs,
+    uint32_t releaseMs)
+{
+    pa_threaded_mainloop_lock(mainloop);
+    int id = duckerCounter++;
+    duckers[id] = _Ducker {
+        trigger, target, depth, attackMs, releaseMs, false, 0., {}};
+    UpdateDucking();
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return id;
+}
+
+bool EventMonitor::StopDucking(int id)
+{
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = duckers.find(id);
+    bool removed = found != duckers.end();
+    if (removed)
+    {
+        found->second.level = 0.;
+        ApplyDucking(found->second);
+        duckers.erase(found);
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return removed;
+}
+
+/**
+ *  \brief      Engages the duckers whose trigger sessions became active and
+ *  releases the others, starting the timer if a ramp must run.
+ */
+void EventMonitor::UpdateDucking()
+{
+    bool ramping = false;
+    for (auto &entry : duckers)
+    {
+        _Ducker &ducker = entry.second;
+        ducker.engaged = false;
+        for (auto &session : sessions)
+        {
+            if (session.second.active
+                && selectorMatches(ducker.trigger, session.second.subject))
+            {
+                ducker.engaged = true;
+                break;
+            }
+        }
+
+        if (ducker.level != (ducker.engaged ? 1. : 0.))
+            ramping = true;
+        else if (ducker.engaged)
+            ApplyDucking(ducker);
+    }
+
+    if (ramping && duckTimer == NULL)
+    {
+        // the first step is taken right away
+        lastDuckTick
+            = Clock::now() - std::chrono::milliseconds(DUCK_TICK_MS);
+        duckTimer = pa_context_rttime_new(ctx, pa_rtclock_now(),
+            (pa_time_event_cb_t)_duck_timer_cb, this);
+    }
+}
+
+void EventMonitor::OnDuckTimer()
+{
+    Clock::time_point now = Clock::now();
+    double elapsed
+        = std::chrono::duration<double, std::milli>(now - lastDuckTick)
+              .count();
+    lastDuckTick = now;
+
+    bool ramping = false;
+    for (auto &entry : duckers)
+    {
+        _Ducker &ducker = entry.second;
+        double goal = ducker.engaged ? 1. : 0.;
+        uint32_t duration
+            = ducker.engaged ? ducker.attackMs : ducker.releaseMs;
+        double step = duration > 0 ? elapsed / duration : 1.;
+        if (ducker.level < goal)
+            ducker.level = std::min(ducker.level + step, goal);
+        else
+            ducker.level = std::max(ducker.level - step, goal);
+
+        ramping = ramping || ducker.level != goal;
+        ApplyDucking(ducker);
+    }
+
+    if (ramping)
+    {
+        pa_context_rttime_restart(ctx, duckTimer,
+            pa_rtclock_now() + DUCK_TICK_MS * PA_USEC_PER_MSEC);
+        return;
+    }
+    pa_threaded_mainloop_get_api(mainloop)->time_free(duckTimer);
+    duckTimer = NULL;
+}
+
+/**
+ *  \brief      Writes the attenuation of the current level to the targets
+ *  of a ducker, following the targets created while it is engaged and
+ *  forgetting them all once restored.
+ */
+void EventMonitor::ApplyDucking(_Ducker &ducker)
+{
+    // ramped in dB, which sounds linear
+    pa_volume_t factor = ducker.level > 0.
+        ? pa_sw_volume_from_dB(-ducker.level * ducker.depth)
+        : PA_VOLUME_NORM;
+    if (ducker.level > 0.)
+    {
+        for (auto &session : sessions)
+        {
+            const Subject &subject = session.second.subject;
+            if (ducker.sessions.count(session.first) == 0
+                && selectorMatches(ducker.target, subject)
+                && !selectorMatches(ducker.trigger, subject))
+            {
+                ducker.sessions[session.first] = _DuckedSession {
+                    session.second.cvolume, session.second.cvolume,
+                    PA_VOLUME_NORM, NULL};
+            }
+        }
+    }
+
+    for (auto &entry : ducker.sessions)
+    {
+        _DuckedSession &ducked = entry.second;
+        if (ducked.factor == factor)
+            continue;
+
+        pa_cvolume vol = ducked.base;
+        for (uint8_t i = 0; i < vol.channels; i++)
+            vol.values[i] = pa_sw_volume_multiply(vol.values[i], factor);
+
+        auto session = sessions.find(entry.first);
+        if (ducked.op != NULL)
+            pa_operation_unref(ducked.op);
+        ducked.op
+            = _set_volume(ctx, session->second.subject.target, &vol);
+        ducked.applied = vol;
+        ducked.factor = factor;
+    }
+
+    if (ducker.level == 0.)
+    {
+        for (auto &entry : ducker.sessions)
+        {
+            if (entry.second.op != NULL)
+                pa_operation_unref(entry.second.op);
+        }
+        ducker.sessions.clear();
+    }
+}
+
+/**
+ *  \brief      Tells the volumes a ducker writes to a session, the last one
+ *  or any while a write is pending, apart from changes made by anyone else,
+ *  which are then reported like EnforceLimit does with clamped writes.
+ */
+bool EventMonitor::DuckingWrote(uint64_t key, const pa_cvolume *volume)
+{
+    for (auto &entry : duckers)
+    {
+        auto found = entry.second.sessions.find(key);
+        if (found == entry.second.sessions.end())
+            continue;
+
+        const _DuckedSession &ducked = found->second;
+        if ((ducked.op != NULL
+                && pa_operation_get_state(ducked.op) == PA_OPERATION_RUNNING)
+            || pa_cvolume_equal(volume, &ducked.applied))
+            return true;
+    }
+    return false;
+}
+
+/**
+ *  \brief      Takes the volume a ducked session has been given by anyone
+ *  else as the volume to restore, once the writes of the ducker are done.
+ *
+ *  \remarks    Only invoked with volumes DuckingWrote does not claim.
+ */
+void EventMonitor::RebaseDucked(uint64_t key, const pa_cvolume *volume)
+{
+    for (auto &entry : duckers)
+    {
+        auto found = entry.second.sessions.find(key);
+        if (found == entry.second.sessions.end())
+            continue;
+
+        _DuckedSession &ducked = found->second;
+
+        ducked.base = *volume;
+        for (uint8_t i = 0; i < volume->channels; i++)
+        {
+            ducked.base.values[i] = std::min(
+                pa_sw_volume_divide(volume->values[i], ducked.factor),
+                (pa_volume_t)PA_VOLUME_MAX);
+        }
+        ducked.applied = *volume;
+    }
+}
+
+bool EventMonitor::LatestActive(int facility, uint32_t index, bool *out)
+{
+    bool found = false;
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto session = sessions.find(STATE_KEY(facility, index));
+    if (session != sessions.end())
+    {
+        *out = session->second.active;
+        found = true;
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return found;
+}
+
+bool EventMonitor::LatestSubject(int facility, uint32_t index, Subject *out)
+{
+    bool found = false;
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto session = sessions.find(STATE_KEY(facility, index));
+    if (session != sessions.end())
+    {
+        *out = session->second.subject;
+        found = true;
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return found;
+}
+
+bool EventMonitor::StepVolume(
+    int facility, uint32_t index, float delta, pa_cvolume *out)
+{
+    bool found = false;
+    uint64_t key = STATE_KEY(facility, index);
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto device = devices.find(key);
+    auto session = sessions.find(key);
+    auto last = written.find(key);
+    if (last != written.end()
+        && pa_rtclock_now() - last->second.at
+            < WRITTEN_VOLUME_TTL_MS * PA_USEC_PER_MSEC)
+    {
+        *out = last->second.volume;
+        found = true;
+    }
+    else if (device != devices.end())
+    {
+        *out = device->second.cvolume;
+        found = true;
+    }
+    else if (session != sessions.end())
+    {
+        *out = session->second.cvolume;
+        found = true;
+    }
+    if (found)
+    {
+        _step_cvolume(out, delta);
+        written[key] = _WrittenVolume {*out, pa_rtclock_now()};
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return found;
+}
+
+void EventMonitor::WroteVolume(
+    int facility, uint32_t index, const pa_cvolume &volume)
+{
+    uint64_t key = STATE_KEY(facility, index);
+
+    pa_threaded_mainloop_lock(mainloop);
+    if (devices.count(key) > 0 || sessions.count(key) > 0)
+        written[key] = _WrittenVolume {volume, pa_rtclock_now()};
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+void EventMonitor::ForgetWritten(uint64_t key, const pa_cvolume *volume)
+{
+    auto last = written.find(key);
+    if (last != written.end()
+        && pa_cvolume_equal(&last->second.volume, volume))
+        written.erase(last);
+}
+
+bool EventMonitor::StartMeter(Target target, DeviceDescriptor desc,
+    uint32_t source, uint32_t stream, uint32_t rateHz)
+{
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+    bool started = false;
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = meters.find(key);
+    if (found != meters.end())
+    {
+        found->second.refs++;
+        started = true;
+    }
+    else if (ready > 0)
+    {
+        pa_sample_spec spec {PA_SAMPLE_FLOAT32NE, rateHz, 1};
+        pa_stream *recorder
+            = pa_stream_new(ctx, "sound-mixer-meter", &spec, NULL);
+        if (recorder != NULL)
+        {
+            _Meter &meter = meters[key];
+            meter = _Meter {this, recorder, 1, target, desc,
+                Subject {target, "", "", ""}, {}, 0, 0.F, {}, {}};
+            auto session = sessions.find(key);
+            if (session != sessions.end())
+                meter.subject = session->second.subject;
+            if (stream != PA_INVALID_INDEX)
+                pa_stream_set_monitor_stream(recorder, stream);
+
+            // one reading per fragment
+            pa_buffer_attr attr;
+            std::memset(&attr, 0xff, sizeof(attr));
+            attr.fragsize = sizeof(float);
+            char device[16];
+            std::snprintf(device, sizeof(device), "%u", source);
+
+            pa_stream_set_read_callback(
+                recorder, (pa_stream_request_cb_t)_meter_read_cb, &meter);
+            started = pa_stream_connect_record(recorder, device, &attr,
+                          (pa_stream_flags_t)(PA_STREAM_DONT_MOVE
+                              | PA_STREAM_PEAK_DETECT
+                              | PA_STREAM_ADJUST_LATENCY))
+                >= 0;
+            if (!started)
+                ReleaseMeter(key);
+        }
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return started;
+}
+
+bool EventMonitor::StartSilenceDetector(Target target, uint32_t source,
+    uint32_t stream, float threshold, uint32_t holdMs)
+{
+    if (!StartMeter(target, DeviceDescriptor(), source, stream,
+            SILENCE_DETECTOR_RATE))
+        return false;
+
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = meters.find(key);
+    if (found != meters.end() && found->second.detectors++ == 0)
+    {
+        // a new detector considers the session loud until proven silent
+        found->second.threshold = threshold;
+        found->second.hold = std::chrono::milliseconds(holdMs);
+        found->second.lastSignal = Clock::now();
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return true;
+}
+
+void EventMonitor::StopSilenceDetector(Target target)
+{
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = meters.find(key);
+    if (found != meters.end() && found->second.detectors > 0)
+    {
+        found->second.detectors--;
+        StopMeter(target);
+        UpdateActivity(key);
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+void EventMonitor::StopMeter(Target target)
+{
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = meters.find(key);
+    if (found != meters.end() && --found->second.refs <= 0)
+    {
+        ReleaseMeter(key);
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+std::shared_ptr<SampleRing> EventMonitor::AttachMeterRing(
+    Target target, uint32_t capacity)
+{
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+    std::shared_ptr<SampleRing> ring;
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = meters.find(key);
+    if (found != meters.end())
+    {
+        ring = std::make_shared<SampleRing>(capacity, 1);
+        found->second.rings.push_back(ring);
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return ring;
+}
+
+void EventMonitor::DetachMeterRing(
+    Target target, const std::shared_ptr<SampleRing> &ring)
+{
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = meters.find(key);
+    if (found != meters.end())
+    {
+        auto &rings = found->second.rings;
+        rings.erase(
+            std::remove(rings.begin(), rings.end(), ring), rings.end());
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+void EventMonitor::ReleaseMeter(uint64_t key)
+{
+    auto found = meters.find(key);
+    if (found == meters.end())
+    {
+        return;
+    }
+
+    pa_stream *stream = found->second.stream;
+    pa_stream_set_read_callback(stream, NULL, NULL);
+    if (pa_stream_get_state(stream) != PA_STREAM_UNCONNECTED)
+        pa_stream_disconnect(stream);
+    pa_stream_unref(stream);
+    meters.erase(found);
+}
+
+_Capture *EventMonitor::OpenCapture(uint32_t source,
+    const pa_sample_spec &spec, uint32_t fragmentMs,
+    on_capture_data_cb_t callback, void *userdata)
+{
+    _Capture *capture = NULL;
+
+    pa_threaded_mainloop_lock(mainloop);
+    pa_stream *stream = ready > 0
+        ? pa_stream_new(ctx, "sound-mixer-capture", &spec, NULL)
+        : NULL;
+    if (stream != NULL)
+    {
+        capture = new _Capture {this, stream, callback, userdata, false};
+
+        pa_buffer_attr attr;
+        std::memset(&attr, 0xff, sizeof(attr));
+        attr.fragsize = (uint32_t)pa_usec_to_bytes(
+            fragmentMs * PA_USEC_PER_MSEC, &spec);
+        char device[16];
+        std::snprintf(device, sizeof(device), "%u", source);
+
+        pa_stream_set_state_callback(
+            stream, (pa_stream_notify_cb_t)_capture_state_cb, capture);
+        pa_stream_set_read_callback(
+            stream, (pa_stream_request_cb_t)_capture_read_cb, capture);
+        if (pa_stream_connect_record(stream, device, &attr,
+                (pa_stream_flags_t)(PA_STREAM_DONT_MOVE
+                    | PA_STREAM_ADJUST_LATENCY))
+            < 0)
+        {
+            ReleaseCapture(capture);
+            capture = NULL;
+        }
+        else
+        {
+            captures.push_back(capture);
+        }
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return capture;
+}
+
+void EventMonitor::CloseCapture(_Capture *capture)
+{
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = std::find(captures.begin(), captures.end(), capture);
+    if (found != captures.end())
+    {
+        captures.erase(found);
+        ReleaseCapture(capture);
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+void EventMonitor::ReleaseCapture(_Capture *capture)
+{
+    pa_stream_set_state_callback(capture->stream, NULL, NULL);
+    pa_stream_set_read_callback(capture->stream, NULL, NULL);
+    if (pa_stream_get_state(capture->stream) != PA_STREAM_UNCONNECTED)
+        pa_stream_disconnect(capture->stream);
+    pa_stream_unref(capture->stream);
+    delete capture;
+}
+
+bool EventMonitor::StartLoudness(Target target, DeviceDescriptor desc,
+    uint32_t source, uint32_t stream, uint32_t intervalMs)
+{
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+    bool started = false;
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = loudnessMeters.find(key);
+    if (found != loudnessMeters.end())
+    {
+        found->second.refs++;
+        started = true;
+    }
+    else if (ready > 0)
+    {
+        // rate and channels are replaced by the ones of the source
+        pa_sample_spec spec {PA_SAMPLE_FLOAT32NE, 48000, 2};
+        pa_stream *recorder
+            = pa_stream_new(ctx, "sound-mixer-loudness", &spec, NULL);
+        if (recorder != NULL)
+        {
+            _Loudness &loudness = loudnessMeters[key];
+            loudness = _Loudness {this, recorder, 1, target, desc,
+                Subject {target, "", "", ""}, intervalMs, NULL, 0, 0, 0.F};
+            auto session = sessions.find(key);
+            if (session != sessions.end())
+                loudness.subject = session->second.subject;
+            if (stream != PA_INVALID_INDEX)
+                pa_stream_set_monitor_stream(recorder, stream);
+
+            // about 20 ms fragments, whatever the format of the source
+            pa_buffer_attr attr;
+            std::memset(&attr, 0xff, sizeof(attr));
+            attr.fragsize
+                = (uint32_t)pa_usec_to_bytes(20 * PA_USEC_PER_MSEC, &spec);
+            char device[16];
+            std::snprintf(device, sizeof(device), "%u", source);
+
+            pa_stream_set_read_callback(recorder,
+                (pa_stream_request_cb_t)_loudness_read_cb, &loudness);
+            started = pa_stream_connect_record(recorder, device, &attr,
+                          (pa_stream_flags_t)(PA_STREAM_DONT_MOVE
+                              | PA_STREAM_FIX_RATE | PA_STREAM_FIX_CHANNELS
+                              | PA_STREAM_ADJUST_LATENCY))
+                >= 0;
+            if (!started)
+                ReleaseLoudness(key);
+        }
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return started;
+}
+
+void EventMonitor::StopLoudness(Target target)
+{
+    uint64_t key = STATE_KEY(_target_facility(target), target.index);
+
+    pa_threaded_mainloop_lock(mainloop);
+    auto found = loudnessMeters.find(key);
+    if (found != loudnessMeters.end() && --found->second.refs <= 0)
+    {
+        ReleaseLoudness(key);
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+void EventMonitor::ReleaseLoudness(uint64_t key)
+{
+    auto found = loudnessMeters.find(key);
+    if (found == loudnessMeters.end())
+    {
+        return;
+    }
+
+    pa_stream *stream = found->second.stream;
+    pa_stream_set_read_callback(stream, NULL, NULL);
+    if (pa_stream_get_state(stream) != PA_STREAM_UNCONNECTED)
+        pa_stream_disconnect(stream);
+    pa_stream_unref(stream);
+    delete found->second.meter;
+    loudnessMeters.erase(found);
+}
+
+void EventMonitor::OnLoudness(_Loudness *loudness)
+{
+    LoudnessReading reading = loudness->meter->Read();
+    NotificationHandler data {DEVICE_CHANGE_MASK_LOUDNESS, 0.F, false,
+        loudness->target, loudness->peak, (float)reading.momentary,
+        (float)reading.shortTerm, (float)reading.integrated, false};
+    loudness->peak = 0.F;
+    if (loudness->target.kind == SoundMixerUtils::TARGET_SESSION)
+        sessionCallback(loudness->subject, data);
+    else
+        deviceCallback(loudness->desc, data);
+}
+
+void EventMonitor::OnPeak(_Meter *meter, float peak)
+{
+    for (auto &ring : meter->rings)
+    {
+        ring->Push(&peak);
+    }
+
+    if (meter->detectors > 0)
+    {
+        if (peak >= meter->threshold)
+            meter->lastSignal = Clock::now();
+        UpdateActivity(
+            STATE_KEY(_target_facility(meter->target), meter->target.index));
+    }
+    if (meter->refs <= meter->detectors)
+        return;
+
+    NotificationHandler data {DEVICE_CHANGE_MASK_PEAK, 0.F, false,
+        meter->target, peak, 0.F, 0.F, 0.F, false};
+    if (meter->target.kind == SoundMixerUtils::TARGET_SESSION)
+        sessionCallback(meter->subject, data);
+    else
+        deviceCallback(meter->desc, data);
+}
+
+} // namespace LinuxSoundMixer
+
+// definition for Device
+namespace LinuxSoundMixer
+{
+
+_Device::_Device(_PAControls controls, uint32_t index) : index(index)
+{
+    pa = controls;
+}
+
+_Device::~_Device()
+{
+}
+
+DeviceDescriptor _Device::ToDeviceDescriptor()
+{
+    return DeviceDescriptor {name(), friendlyName(), type()};
+}
+
+bool _Device::StartMeter(uint32_t rateHz)
+{
+    if (pa.monitor == NULL)
+    {
+        return false;
+    }
+
+    Target target {SoundMixerUtils::TARGET_DEVICE, type(), index};
+    return pa.monitor->StartMeter(target, ToDeviceDescriptor(),
+        MeterSource(), PA_INVALID_INDEX, rateHz);
+}
+
+bool _Device::SetMaxVolume(pa_volume_t max)
+{
+    if (pa.monitor == NULL)
+    {
+        return false;
+    }
+
+    pa.monitor->SetMaxVolume(
+        Target {SoundMixerUtils::TARGET_DEVICE, type(), index}, max);
+    return true;
+}
+
+bool _Device::PlaySample(const std::string &sample, pa_volume_t volume)
+{
+    if (type() != DeviceType::OUTPUT)
+    {
+        return false;
+    }
+
+    size_t played = 0;
+    std::string sink = name();
+    pa_operation *op = pa_context_play_sample(pa.ctx, sample.c_str(),
+        sink.c_str(), volume, (pa_context_success_cb_t)_count_success_cb,
+        &played);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    return played > 0;
+}
+
+void _Device::StopMeter()
+{
+    if (pa.monitor != NULL)
+    {
+        pa.monitor->StopMeter(
+            Target {SoundMixerUtils::TARGET_DEVICE, type(), index});
+    }
+}
+
+bool _Device::StartLoudness(uint32_t intervalMs)
+{
+    if (pa.monitor == NULL)
+    {
+        return false;
+    }
+
+    Target target {SoundMixerUtils::TARGET_DEVICE, type(), index};
+    return pa.monitor->StartLoudness(target, ToDeviceDescriptor(),
+        MeterSource(), PA_INVALID_INDEX, intervalMs);
+}
+
+void _Device::StopLoudness()
+{
+    if (pa.monitor != NULL)
+    {
+        pa.monitor->StopLoudness(
+            Target {SoundMixerUtils::TARGET_DEVICE, type(), index});
+    }
+}
+
+std::shared_ptr<SampleRing> _Device::AttachMeterRing(uint32_t capacity)
+{
+    if (pa.monitor == NULL)
+    {
+        return NULL;
+    }
+
+    return pa.monitor->AttachMeterRing(
+        Target {SoundMixerUtils::TARGET_DEVICE, type(), index}, capacity);
+}
+
+void _Device::DetachMeterRing(const std::shared_ptr<SampleRing> &ring)
+{
+    if (pa.monitor != NULL)
+    {
+        pa.monitor->DetachMeterRing(
+            Target {SoundMixerUtils::TARGET_DEVICE, type(), index}, ring);
+    }
+}
+
+_Capture *_Device::OpenCapture(const pa_sample_spec &spec,
+    uint32_t fragmentMs, on_capture_data_cb_t callback, void *userdata)
+{
+    if (pa.monitor == NULL)
+    {
+        return NULL;
+    }
+
+    return pa.monitor->OpenCapture(
+        MeterSource(), spec, fragmentMs, callback, userdata);
 }
 
 // InputDevice
@@ -205,7 +2096,7 @@ float InputDevice::GetVolume()
 {
     auto *info = GetInfo();
     pa_volume_t volume = pa_cvolume_avg(&(info->volume));
-    return (float)volume / MAX_VOLUME;
+    return VolumeToScalar(volume);
 }
 
 bool InputDevice::GetMute()
@@ -217,12 +2108,12 @@ bool InputDevice::GetMute()
 
 void InputDevice::SetVolume(float v)
 {
-    if (v > 1 || v < 0)
+    if (!ValidScalar(v))
     {
         return;
     }
 
-    uint32_t volume = v * MAX_VOLUME;
+    pa_volume_t volume = VolumeFromScalar(v);
     pa_source_info *info = GetInfo();
 
     pa_cvolume vol = info->volume;
@@ -230,10 +2121,31 @@ void InputDevice::SetVolume(float v)
     {
         vol.values[i] = volume;
     }
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SOURCE, index, vol);
+    pa_operation *op = pa_context_set_source_volume_by_index(
+        pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
+float InputDevice::StepVolume(float delta)
+{
+    pa_cvolume vol;
+    if (pa.monitor == NULL
+        || !pa.monitor->StepVolume(
+            PA_SUBSCRIPTION_EVENT_SOURCE, index, delta, &vol))
+    {
+        vol = GetInfo()->volume;
+        _step_cvolume(&vol, delta);
+    }
+
     pa_operation *op = pa_context_set_source_volume_by_index(
         pa.ctx, index, &vol, NULL, NULL);
     WAIT(op, pa.mainloop);
     pa_operation_unref(op);
+
+    return VolumeToScalar(pa_cvolume_avg(&vol));
 }
 
 void InputDevice::SetMute(bool mute)
@@ -260,12 +2172,10 @@ VolumeBalance InputDevice::GetVolumeBalance()
         switch (info->channel_map.map[i])
         {
             case PA_CHANNEL_POSITION_LEFT:
-                result.left
-                    = ((float)info->volume.values[i]) / (float)MAX_VOLUME;
+                result.left = VolumeToScalar(info->volume.values[i]);
                 break;
             case PA_CHANNEL_POSITION_RIGHT:
-                result.right
-                    = ((float)info->volume.values[i]) / (float)MAX_VOLUME;
+                result.right = VolumeToScalar(info->volume.values[i]);
                 break;
             default:
                 break;
@@ -279,20 +2189,61 @@ void InputDevice::SetVolumeBalance(const VolumeBalance &balance)
 {
     auto *info = GetInfo();
     pa_cvolume vol = info->volume;
-    if (vol.channels < 2 || !VALID_VOLUME_BALANCE(balance))
+    if (vol.channels < 2 || !ValidScalar(balance.left)
+        || !ValidScalar(balance.right))
     {
         return;
     }
 
-    // TODO : implement channel mapping
-    vol.values[0] = balance.left * MAX_VOLUME;
-    vol.values[1] = balance.right * MAX_VOLUME;
+    ChannelVolumes values {2,
+        {PA_CHANNEL_POSITION_LEFT, PA_CHANNEL_POSITION_RIGHT},
+        {balance.left, balance.right}, true};
+    _apply_channel_volumes(&info->channel_map, &vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SOURCE, index, vol);
     pa_operation *op = pa_context_set_source_volume_by_index(
         pa.ctx, info->index, &vol, NULL, NULL);
     WAIT(op, pa.mainloop);
     pa_operation_unref(op);
 }
 
+ChannelVolumes InputDevice::GetChannelVolumes()
+{
+    pa_source_info *info = GetInfo();
+    return _channel_volumes(&info->channel_map, &info->volume);
+}
+
+void InputDevice::SetChannelVolumes(const ChannelVolumes &values)
+{
+    pa_source_info *info = GetInfo();
+    pa_cvolume vol = info->volume;
+    _apply_channel_volumes(&info->channel_map, &vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SOURCE, index, vol);
+    pa_operation *op = pa_context_set_source_volume_by_index(
+        pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
+pa_cvolume InputDevice::GetRawVolume()
+{
+    return GetInfo()->volume;
+}
+
+void InputDevice::SetRawVolume(const pa_cvolume &values)
+{
+    pa_source_info *info = GetInfo();
+    pa_cvolume vol = info->volume;
+    _apply_raw_volume(&vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SOURCE, index, vol);
+    pa_operation *op = pa_context_set_source_volume_by_index(
+        pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
 struct _AudioSessionData
 {
     uint32_t deviceIndex;
@@ -368,6 +2319,11 @@ std::string InputDevice::friendlyName()
     return name;
 }
 
+uint32_t InputDevice::MeterSource()
+{
+    return index;
+}
+
 DeviceType InputDevice::type()
 {
     return DeviceType::INPUT;
@@ -412,7 +2368,7 @@ float OutputDevice::GetVolume()
 {
     auto *info = GetInfo();
     pa_volume_t volume = pa_cvolume_avg(&(info->volume));
-    return (float)volume / MAX_VOLUME;
+    return VolumeToScalar(volume);
 }
 
 bool OutputDevice::GetMute()
@@ -424,11 +2380,11 @@ bool OutputDevice::GetMute()
 
 void OutputDevice::SetVolume(float v)
 {
-    if (v > 1 || v < 0)
+    if (!ValidScalar(v))
     {
         return;
     }
-    uint32_t volume = v * MAX_VOLUME;
+    pa_volume_t volume = VolumeFromScalar(v);
     auto *info = GetInfo();
 
     pa_cvolume vol = info->volume;
@@ -436,12 +2392,33 @@ void OutputDevice::SetVolume(float v)
     {
         vol.values[i] = volume;
     }
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SINK, index, vol);
     pa_operation *op = pa_context_set_sink_volume_by_index(
         pa.ctx, info->index, &vol, NULL, NULL);
     WAIT(op, pa.mainloop);
     pa_operation_unref(op);
 }
 
+float OutputDevice::StepVolume(float delta)
+{
+    pa_cvolume vol;
+    if (pa.monitor == NULL
+        || !pa.monitor->StepVolume(
+            PA_SUBSCRIPTION_EVENT_SINK, index, delta, &vol))
+    {
+        vol = GetInfo()->volume;
+        _step_cvolume(&vol, delta);
+    }
+
+    pa_operation *op = pa_context_set_sink_volume_by_index(
+        pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    return VolumeToScalar(pa_cvolume_avg(&vol));
+}
+
 void OutputDevice::SetMute(bool mute)
 {
     pa_operation *op = pa_context_set_sink_mute_by_index(
@@ -461,12 +2438,10 @@ VolumeBalance OutputDevice::GetVolumeBalance()
         switch (info->channel_map.map[i])
         {
             case PA_CHANNEL_POSITION_LEFT:
-                result.left
-                    = ((float)info->volume.values[i]) / (float)MAX_VOLUME;
+                result.left = VolumeToScalar(info->volume.values[i]);
                 break;
             case PA_CHANNEL_POSITION_RIGHT:
-                result.right
-                    = ((float)info->volume.values[i]) / (float)MAX_VOLUME;
+                result.right = VolumeToScalar(info->volume.values[i]);
                 break;
             default:
                 break;
@@ -479,20 +2454,61 @@ void OutputDevice::SetVolumeBalance(const VolumeBalance &balance)
 {
     auto *info = GetInfo();
     pa_cvolume vol = info->volume;
-    if (vol.channels < 2 || !VALID_VOLUME_BALANCE(balance))
+    if (vol.channels < 2 || !ValidScalar(balance.left)
+        || !ValidScalar(balance.right))
     {
         return;
     }
 
-    // TODO : implement channel mapping
-    vol.values[0] = balance.left * MAX_VOLUME;
-    vol.values[1] = balance.right * MAX_VOLUME;
+    ChannelVolumes values {2,
+        {PA_CHANNEL_POSITION_LEFT, PA_CHANNEL_POSITION_RIGHT},
+        {balance.left, balance.right}, true};
+    _apply_channel_volumes(&info->channel_map, &vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SINK, index, vol);
     pa_operation *op = pa_context_set_sink_volume_by_index(
         pa.ctx, info->index, &vol, NULL, NULL);
     WAIT(op, pa.mainloop);
     pa_operation_unref(op);
 }
 
+ChannelVolumes OutputDevice::GetChannelVolumes()
+{
+    pa_sink_info *info = GetInfo();
+    return _channel_volumes(&info->channel_map, &info->volume);
+}
+
+void OutputDevice::SetChannelVolumes(const ChannelVolumes &values)
+{
+    pa_sink_info *info = GetInfo();
+    pa_cvolume vol = info->volume;
+    _apply_channel_volumes(&info->channel_map, &vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SINK, index, vol);
+    pa_operation *op
+        = pa_context_set_sink_volume_by_index(pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
+pa_cvolume OutputDevice::GetRawVolume()
+{
+    return GetInfo()->volume;
+}
+
+void OutputDevice::SetRawVolume(const pa_cvolume &values)
+{
+    pa_sink_info *info = GetInfo();
+    pa_cvolume vol = info->volume;
+    _apply_raw_volume(&vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SINK, index, vol);
+    pa_operation *op
+        = pa_context_set_sink_volume_by_index(pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
 void _input_device_get_audio_sessions_cb(pa_context *ctx,
     pa_sink_input_info *info, int eol, struct _AudioSessionData *data)
 {
@@ -526,6 +2542,11 @@ vector<_AudioSession *> OutputDevice::GetAudioSessions()
     return sessions;
 }
 
+uint32_t OutputDevice::MeterSource()
+{
+    return GetInfo()->monitor_source;
+}
+
 DeviceType OutputDevice::type()
 {
     return DeviceType::OUTPUT;
@@ -586,6 +2607,120 @@ _AudioSession::~_AudioSession()
 {
 }
 
+bool _AudioSession::StartMeter(uint32_t rateHz)
+{
+    if (pa.monitor == NULL)
+    {
+        return false;
+    }
+
+    Target target {SoundMixerUtils::TARGET_SESSION, type(), index};
+    return pa.monitor->StartMeter(target, DeviceDescriptor(), MeterSource(),
+        MeterStream(), rateHz);
+}
+
+void _AudioSession::StopMeter()
+{
+    if (pa.monitor != NULL)
+    {
+        pa.monitor->StopMeter(
+            Target {SoundMixerUtils::TARGET_SESSION, type(), index});
+    }
+}
+
+bool _AudioSession::LatestSubject(Subject *out)
+{
+    Target target {SoundMixerUtils::TARGET_SESSION, type(), index};
+    return pa.monitor != NULL
+        && pa.monitor->LatestSubject(_target_facility(target), index, out);
+}
+
+bool _AudioSession::StartSilenceDetector(float threshold, uint32_t holdMs)
+{
+    if (pa.monitor == NULL)
+    {
+        return false;
+    }
+
+    Target target {SoundMixerUtils::TARGET_SESSION, type(), index};
+    return pa.monitor->StartSilenceDetector(
+        target, MeterSource(), MeterStream(), threshold, holdMs);
+}
+
+bool _AudioSession::SetMaxVolume(pa_volume_t max)
+{
+    if (pa.monitor == NULL)
+    {
+        return false;
+    }
+
+    pa.monitor->SetMaxVolume(
+        Target {SoundMixerUtils::TARGET_SESSION, type(), index}, max);
+    return true;
+}
+
+bool _AudioSession::MoveTo(uint32_t device)
+{
+    size_t moved = 0;
+    pa_operation *op = _move_session(pa.ctx,
+        Target {SoundMixerUtils::TARGET_SESSION, type(), index}, device,
+        &moved);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    return moved > 0;
+}
+
+void _AudioSession::StopSilenceDetector()
+{
+    if (pa.monitor != NULL)
+    {
+        pa.monitor->StopSilenceDetector(
+            Target {SoundMixerUtils::TARGET_SESSION, type(), index});
+    }
+}
+
+bool _AudioSession::StartLoudness(uint32_t intervalMs)
+{
+    if (pa.monitor == NULL)
+    {
+        return false;
+    }
+
+    Target target {SoundMixerUtils::TARGET_SESSION, type(), index};
+    return pa.monitor->StartLoudness(target, DeviceDescriptor(),
+        MeterSource(), MeterStream(), intervalMs);
+}
+
+void _AudioSession::StopLoudness()
+{
+    if (pa.monitor != NULL)
+    {
+        pa.monitor->StopLoudness(
+            Target {SoundMixerUtils::TARGET_SESSION, type(), index});
+    }
+}
+
+std::shared_ptr<SampleRing> _AudioSession::AttachMeterRing(uint32_t capacity)
+{
+    if (pa.monitor == NULL)
+    {
+        return NULL;
+    }
+
+    return pa.monitor->AttachMeterRing(
+        Target {SoundMixerUtils::TARGET_SESSION, type(), index}, capacity);
+}
+
+void _AudioSession::DetachMeterRing(const std::shared_ptr<SampleRing> &ring)
+{
+    if (pa.monitor != NULL)
+    {
+        pa.monitor->DetachMeterRing(
+            Target {SoundMixerUtils::TARGET_SESSION, type(), index}, ring);
+    }
+}
+
 InputAudioSession::InputAudioSession(_PAControls controls, uint32_t index)
     : _AudioSession(controls, index)
 {
@@ -624,7 +2759,7 @@ float InputAudioSession::GetVolume()
 {
     auto *info = GetInfo();
     pa_volume_t volume = pa_cvolume_avg(&(info->volume));
-    return (float)volume / MAX_VOLUME;
+    return VolumeToScalar(volume);
 }
 
 bool InputAudioSession::GetMute()
@@ -636,11 +2771,11 @@ bool InputAudioSession::GetMute()
 
 void InputAudioSession::SetVolume(float v)
 {
-    if (v > 1 || v < 0)
+    if (!ValidScalar(v))
     {
         return;
     }
-    uint32_t volume = v * MAX_VOLUME;
+    pa_volume_t volume = VolumeFromScalar(v);
     auto *info = GetInfo();
 
     pa_cvolume vol = info->volume;
@@ -648,10 +2783,32 @@ void InputAudioSession::SetVolume(float v)
     {
         vol.values[i] = volume;
     }
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(
+            PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, index, vol);
+    pa_operation *op
+        = pa_context_set_source_output_volume(pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
+float InputAudioSession::StepVolume(float delta)
+{
+    pa_cvolume vol;
+    if (pa.monitor == NULL
+        || !pa.monitor->StepVolume(
+            PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, index, delta, &vol))
+    {
+        vol = GetInfo()->volume;
+        _step_cvolume(&vol, delta);
+    }
+
     pa_operation *op
         = pa_context_set_source_output_volume(pa.ctx, index, &vol, NULL, NULL);
     WAIT(op, pa.mainloop);
     pa_operation_unref(op);
+
+    return VolumeToScalar(pa_cvolume_avg(&vol));
 }
 
 void InputAudioSession::SetMute(bool mute)
@@ -678,12 +2835,10 @@ VolumeBalance InputAudioSession::GetVolumeBalance()
         switch (info->channel_map.map[i])
         {
             case PA_CHANNEL_POSITION_LEFT:
-                result.left
-                    = ((float)info->volume.values[i]) / (float)MAX_VOLUME;
+                result.left = VolumeToScalar(info->volume.values[i]);
                 break;
             case PA_CHANNEL_POSITION_RIGHT:
-                result.right
-                    = ((float)info->volume.values[i]) / (float)MAX_VOLUME;
+                result.right = VolumeToScalar(info->volume.values[i]);
                 break;
             default:
                 break;
@@ -697,20 +2852,64 @@ void InputAudioSession::SetVolumeBalance(const VolumeBalance &balance)
 {
     auto *info = GetInfo();
     pa_cvolume vol = info->volume;
-    if (vol.channels < 2 || !VALID_VOLUME_BALANCE(balance))
+    if (vol.channels < 2 || !ValidScalar(balance.left)
+        || !ValidScalar(balance.right))
     {
         return;
     }
 
-    // TODO : implement channel mapping
-    vol.values[0] = balance.left * MAX_VOLUME;
-    vol.values[1] = balance.right * MAX_VOLUME;
+    ChannelVolumes values {2,
+        {PA_CHANNEL_POSITION_LEFT, PA_CHANNEL_POSITION_RIGHT},
+        {balance.left, balance.right}, true};
+    _apply_channel_volumes(&info->channel_map, &vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(
+            PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, index, vol);
     pa_operation *op = pa_context_set_source_output_volume(
         pa.ctx, info->index, &vol, NULL, NULL);
     WAIT(op, pa.mainloop);
     pa_operation_unref(op);
 }
 
+ChannelVolumes InputAudioSession::GetChannelVolumes()
+{
+    pa_source_output_info *info = GetInfo();
+    return _channel_volumes(&info->channel_map, &info->volume);
+}
+
+void InputAudioSession::SetChannelVolumes(const ChannelVolumes &values)
+{
+    pa_source_output_info *info = GetInfo();
+    pa_cvolume vol = info->volume;
+    _apply_channel_volumes(&info->channel_map, &vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(
+            PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, index, vol);
+    pa_operation *op
+        = pa_context_set_source_output_volume(pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
+pa_cvolume InputAudioSession::GetRawVolume()
+{
+    return GetInfo()->volume;
+}
+
+void InputAudioSession::SetRawVolume(const pa_cvolume &values)
+{
+    pa_source_output_info *info = GetInfo();
+    pa_cvolume vol = info->volume;
+    _apply_raw_volume(&vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(
+            PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, index, vol);
+    pa_operation *op
+        = pa_context_set_source_output_volume(pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
 std::string InputAudioSession::description()
 {
     auto *s = GetInfo();
@@ -751,6 +2950,52 @@ std::string InputAudioSession::appName()
     return name;
 }
 
+uint32_t InputAudioSession::MeterSource()
+{
+    return GetInfo()->source;
+}
+
+uint32_t InputAudioSession::MeterStream()
+{
+    // a source output cannot be monitored, its source is recorded instead
+    return PA_INVALID_INDEX;
+}
+
+DeviceType InputAudioSession::type()
+{
+    return DeviceType::INPUT;
+}
+
+void _source_output_corked_cb(pa_context *ctx,
+    const pa_source_output_info *info, int eol, int *corked)
+{
+    if (!eol)
+        *corked = info->corked;
+}
+
+SessionState InputAudioSession::GetState()
+{
+    // the monitor also knows about the silence detector, the server only
+    // about the corked state
+    bool active;
+    if (pa.monitor != NULL
+        && pa.monitor->LatestActive(
+            PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, index, &active))
+    {
+        return active ? SESSION_ACTIVE : SESSION_INACTIVE;
+    }
+
+    int corked = -1;
+    pa_operation *op = pa_context_get_source_output_info(pa.ctx, index,
+        (pa_source_output_info_cb_t)_source_output_corked_cb, &corked);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    if (corked < 0)
+        return SESSION_EXPIRED;
+    return corked ? SESSION_INACTIVE : SESSION_ACTIVE;
+}
+
 // OutputAudioSession
 OutputAudioSession::OutputAudioSession(_PAControls controls, uint32_t index)
     : _AudioSession(controls, index)
@@ -783,7 +3028,7 @@ float OutputAudioSession::GetVolume()
 {
     auto *info = GetInfo();
     pa_volume_t volume = pa_cvolume_avg(&(info->volume));
-    return (float)volume / MAX_VOLUME;
+    return VolumeToScalar(volume);
 }
 
 bool OutputAudioSession::GetMute()
@@ -795,11 +3040,11 @@ bool OutputAudioSession::GetMute()
 
 void OutputAudioSession::SetVolume(float v)
 {
-    if (v > 1 || v < 0)
+    if (!ValidScalar(v))
     {
         return;
     }
-    uint32_t volume = v * MAX_VOLUME;
+    pa_volume_t volume = VolumeFromScalar(v);
     auto *info = GetInfo();
 
     pa_cvolume vol = info->volume;
@@ -807,10 +3052,31 @@ void OutputAudioSession::SetVolume(float v)
     {
         vol.values[i] = volume;
     }
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SINK_INPUT, index, vol);
+    pa_operation *op
+        = pa_context_set_sink_input_volume(pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
+float OutputAudioSession::StepVolume(float delta)
+{
+    pa_cvolume vol;
+    if (pa.monitor == NULL
+        || !pa.monitor->StepVolume(
+            PA_SUBSCRIPTION_EVENT_SINK_INPUT, index, delta, &vol))
+    {
+        vol = GetInfo()->volume;
+        _step_cvolume(&vol, delta);
+    }
+
     pa_operation *op
         = pa_context_set_sink_input_volume(pa.ctx, index, &vol, NULL, NULL);
     WAIT(op, pa.mainloop);
     pa_operation_unref(op);
+
+    return VolumeToScalar(pa_cvolume_avg(&vol));
 }
 
 void OutputAudioSession::SetMute(bool mute)
@@ -832,12 +3098,10 @@ VolumeBalance OutputAudioSession::GetVolumeBalance()
         switch (info->channel_map.map[i])
         {
             case PA_CHANNEL_POSITION_LEFT:
-                result.left
-                    = ((float)info->volume.values[i]) / (float)MAX_VOLUME;
+                result.left = VolumeToScalar(info->volume.values[i]);
                 break;
             case PA_CHANNEL_POSITION_RIGHT:
-                result.right
-                    = ((float)info->volume.values[i]) / (float)MAX_VOLUME;
+                result.right = VolumeToScalar(info->volume.values[i]);
                 break;
             default:
                 break;
@@ -850,20 +3114,61 @@ void OutputAudioSession::SetVolumeBalance(const VolumeBalance &balance)
 {
     auto *info = GetInfo();
     pa_cvolume vol = info->volume;
-    if (vol.channels < 2 || !VALID_VOLUME_BALANCE(balance))
+    if (vol.channels < 2 || !ValidScalar(balance.left)
+        || !ValidScalar(balance.right))
     {
         return;
     }
 
-    // TODO : implement channel mapping
-    vol.values[0] = balance.left * MAX_VOLUME;
-    vol.values[1] = balance.right * MAX_VOLUME;
+    ChannelVolumes values {2,
+        {PA_CHANNEL_POSITION_LEFT, PA_CHANNEL_POSITION_RIGHT},
+        {balance.left, balance.right}, true};
+    _apply_channel_volumes(&info->channel_map, &vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SINK_INPUT, index, vol);
     pa_operation *op = pa_context_set_sink_input_volume(
         pa.ctx, info->index, &vol, NULL, NULL);
     WAIT(op, pa.mainloop);
     pa_operation_unref(op);
 }
 
+ChannelVolumes OutputAudioSession::GetChannelVolumes()
+{
+    pa_sink_input_info *info = GetInfo();
+    return _channel_volumes(&info->channel_map, &info->volume);
+}
+
+void OutputAudioSession::SetChannelVolumes(const ChannelVolumes &values)
+{
+    pa_sink_input_info *info = GetInfo();
+    pa_cvolume vol = info->volume;
+    _apply_channel_volumes(&info->channel_map, &vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SINK_INPUT, index, vol);
+    pa_operation *op
+        = pa_context_set_sink_input_volume(pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
+pa_cvolume OutputAudioSession::GetRawVolume()
+{
+    return GetInfo()->volume;
+}
+
+void OutputAudioSession::SetRawVolume(const pa_cvolume &values)
+{
+    pa_sink_input_info *info = GetInfo();
+    pa_cvolume vol = info->volume;
+    _apply_raw_volume(&vol, values);
+    if (pa.monitor != NULL)
+        pa.monitor->WroteVolume(PA_SUBSCRIPTION_EVENT_SINK_INPUT, index, vol);
+    pa_operation *op
+        = pa_context_set_sink_input_volume(pa.ctx, index, &vol, NULL, NULL);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+}
+
 std::string OutputAudioSession::description()
 {
     auto *s = GetInfo();
@@ -904,4 +3209,49 @@ std::string OutputAudioSession::appName()
     return name;
 }
 
+uint32_t OutputAudioSession::MeterSource()
+{
+    return OutputDevice(pa, GetInfo()->sink).MeterSource();
+}
+
+uint32_t OutputAudioSession::MeterStream()
+{
+    return index;
+}
+
+DeviceType OutputAudioSession::type()
+{
+    return DeviceType::OUTPUT;
+}
+
+void _sink_input_corked_cb(pa_context *ctx, const pa_sink_input_info *info,
+    int eol, int *corked)
+{
+    if (!eol)
+        *corked = info->corked;
+}
+
+SessionState OutputAudioSession::GetState()
+{
+    // the monitor also knows about the silence detector, the server only
+    // about the corked state
+    bool active;
+    if (pa.monitor != NULL
+        && pa.monitor->LatestActive(
+            PA_SUBSCRIPTION_EVENT_SINK_INPUT, index, &active))
+    {
+        return active ? SESSION_ACTIVE : SESSION_INACTIVE;
+    }
+
+    int corked = -1;
+    pa_operation *op = pa_context_get_sink_input_info(pa.ctx, index,
+        (pa_sink_input_info_cb_t)_sink_input_corked_cb, &corked);
+    WAIT(op, pa.mainloop);
+    pa_operation_unref(op);
+
+    if (corked < 0)
+        return SESSION_EXPIRED;
+    return corked ? SESSION_INACTIVE : SESSION_ACTIVE;
+}
+
 }; // namespace LinuxSoundMixer
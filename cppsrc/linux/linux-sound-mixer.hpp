@@ -1,29 +1,87 @@
 #pragma once
 
+#include <map>
+#include <memory>
 #include <pulse/pulseaudio.h>
+#include <set>
 #include <string>
 #include <vector>
+#include "loudness.hpp"
+#include "sample-ring.hpp"
 #include "sound-mixer-utils.hpp"
 
 using SoundMixerUtils::DeviceDescriptor;
 using SoundMixerUtils::DeviceType;
+using SoundMixerUtils::Matcher;
+using SoundMixerUtils::NotificationHandler;
+using SoundMixerUtils::Selector;
+using SoundMixerUtils::Subject;
+using SoundMixerUtils::Target;
 using SoundMixerUtils::VolumeBalance;
 
 namespace LinuxSoundMixer
 {
 
+typedef void (*on_device_changed_cb_t)(
+    DeviceDescriptor dev, NotificationHandler);
+typedef void (*on_session_changed_cb_t)(Subject, NotificationHandler);
+
+/**
+ *  \brief      Receives the fragments of a capture stream on the mainloop
+ *  thread, data being NULL once the stream has ended.
+ */
+typedef void (*on_capture_data_cb_t)(
+    void *userdata, const void *data, size_t length);
+
+class EventMonitor;
+
+/**
+ *  \brief      The values of AudioSessionState.
+ */
+enum SessionState
+{
+    SESSION_INACTIVE = 0,
+    SESSION_ACTIVE = 1,
+    SESSION_EXPIRED = 2
+};
+
+typedef struct
+{
+    EventMonitor *monitor;
+    pa_stream *stream;
+    on_capture_data_cb_t callback;
+    void *userdata;
+    bool ended;
+} _Capture;
+
 typedef struct _PAControls
 {
     pa_mainloop *mainloop;
     pa_mainloop_api *api;
     pa_context *ctx;
+    // latest known state of the server objects, may be NULL
+    EventMonitor *monitor;
 } _PAControls;
 
+/**
+ *  \brief      The volume of every channel of an object, along with the
+ *  position of the channel in the channel map of the object.
+ */
+typedef struct
+{
+    uint8_t channels;
+    uint8_t positions[PA_CHANNELS_MAX];
+    float volumes[PA_CHANNELS_MAX];
+    // when false, volumes are applied by channel index and positions ignored
+    bool mapped;
+} ChannelVolumes;
+
 class _AudioSession {
   public:
     uint32_t index;
     virtual std::string description() = 0;
     virtual std::string appName() = 0;
+    virtual DeviceType type() = 0;
 
   protected:
     _PAControls pa;
@@ -33,10 +91,74 @@ class _AudioSession {
     virtual ~_AudioSession();
     virtual float GetVolume() = 0;
     virtual void SetVolume(float) = 0;
+    virtual float StepVolume(float) = 0;
     virtual bool GetMute() = 0;
     virtual void SetMute(bool) = 0;
     virtual VolumeBalance GetVolumeBalance() = 0;
     virtual void SetVolumeBalance(const VolumeBalance &) = 0;
+    virtual ChannelVolumes GetChannelVolumes() = 0;
+    virtual void SetChannelVolumes(const ChannelVolumes &) = 0;
+    virtual pa_cvolume GetRawVolume() = 0;
+    virtual void SetRawVolume(const pa_cvolume &) = 0;
+
+    /**
+     *  \brief      SESSION_INACTIVE while the stream is corked or silenced
+     *  by the silence detector, SESSION_EXPIRED once it has been removed.
+     */
+    virtual SessionState GetState() = 0;
+
+    /**
+     *  \brief      Also considers the session inactive once its peaks have
+     *  stayed below threshold for holdMs.
+     *  \see        EventMonitor::StartSilenceDetector
+     */
+    bool StartSilenceDetector(float threshold, uint32_t holdMs);
+    void StopSilenceDetector();
+
+    /**
+     *  \brief      Reads the name and application name of the session from
+     *  the EventMonitor, without any round trip.
+     *
+     *  \return     false if there is no EventMonitor or it does not know
+     *  the session.
+     */
+    bool LatestSubject(Subject *out);
+
+    /**
+     *  \brief      Starts delivering the signal peak of the session through
+     *  the session callback of the EventMonitor.
+     *  \see        _Device::StartMeter
+     */
+    bool StartMeter(uint32_t rateHz);
+    void StopMeter();
+    std::shared_ptr<SampleRing> AttachMeterRing(uint32_t capacity);
+    void DetachMeterRing(const std::shared_ptr<SampleRing> &ring);
+
+    /**
+     *  \brief      Starts reporting the loudness of the session through the
+     *  session callback of the EventMonitor.
+     *  \see        _Device::StartLoudness
+     */
+    bool StartLoudness(uint32_t intervalMs);
+    void StopLoudness();
+
+    /**
+     *  \see        _Device::SetMaxVolume
+     */
+    bool SetMaxVolume(pa_volume_t max);
+
+    /**
+     *  \brief      Moves the session to another device of its type.
+     *
+     *  \return     false if the server refused the move.
+     */
+    bool MoveTo(uint32_t device);
+
+  protected:
+    // the source recorded by the meter and the stream it is restricted to,
+    // PA_INVALID_INDEX to record the whole source
+    virtual uint32_t MeterSource() = 0;
+    virtual uint32_t MeterStream() = 0;
 };
 
 class InputAudioSession : public _AudioSession {
@@ -44,14 +166,25 @@ class InputAudioSession : public _AudioSession {
     InputAudioSession(_PAControls, uint32_t);
     float GetVolume();
     void SetVolume(float);
+    float StepVolume(float);
     bool GetMute();
     void SetMute(bool);
     void SetVolumeBalance(const VolumeBalance &);
     VolumeBalance GetVolumeBalance();
+    ChannelVolumes GetChannelVolumes();
+    void SetChannelVolumes(const ChannelVolumes &);
+    pa_cvolume GetRawVolume();
+    void SetRawVolume(const pa_cvolume &);
+    SessionState GetState();
 
   public:
     std::string description();
     std::string appName();
+    DeviceType type();
+
+  protected:
+    uint32_t MeterSource();
+    uint32_t MeterStream();
 
   private:
     pa_source_output_info *GetInfo();
@@ -63,14 +196,25 @@ class OutputAudioSession : public _AudioSession {
     OutputAudioSession(_PAControls, uint32_t);
     float GetVolume();
     void SetVolume(float);
+    float StepVolume(float);
     bool GetMute();
     void SetMute(bool);
     void SetVolumeBalance(const VolumeBalance &);
     VolumeBalance GetVolumeBalance();
+    ChannelVolumes GetChannelVolumes();
+    void SetChannelVolumes(const ChannelVolumes &);
+    pa_cvolume GetRawVolume();
+    void SetRawVolume(const pa_cvolume &);
+    SessionState GetState();
 
   public:
     std::string description();
     std::string appName();
+    DeviceType type();
+
+  protected:
+    uint32_t MeterSource();
+    uint32_t MeterStream();
 
   private:
     pa_sink_input_info *GetInfo();
@@ -93,11 +237,77 @@ class _Device {
     virtual ~_Device();
     virtual float GetVolume() = 0;
     virtual void SetVolume(float) = 0;
+    virtual float StepVolume(float) = 0;
     virtual bool GetMute() = 0;
     virtual void SetMute(bool) = 0;
     virtual void SetVolumeBalance(const VolumeBalance &) = 0;
     virtual VolumeBalance GetVolumeBalance() = 0;
+    virtual ChannelVolumes GetChannelVolumes() = 0;
+    virtual void SetChannelVolumes(const ChannelVolumes &) = 0;
+    virtual pa_cvolume GetRawVolume() = 0;
+    virtual void SetRawVolume(const pa_cvolume &) = 0;
     virtual std::vector<_AudioSession *> GetAudioSessions() = 0;
+
+    /**
+     *  \brief      Starts delivering the signal peak of the device, at
+     *  rateHz readings per second, through the device callback of the
+     *  EventMonitor. Meters are shared and reference counted.
+     *
+     *  \return     false if there is no EventMonitor or the stream could not
+     *  be created.
+     */
+    bool StartMeter(uint32_t rateHz);
+    void StopMeter();
+
+    /**
+     *  \brief      Adds a ring the running meter writes its readings to, one
+     *  float per slot.
+     *
+     *  \return     NULL if the meter is not running.
+     */
+    std::shared_ptr<SampleRing> AttachMeterRing(uint32_t capacity);
+    void DetachMeterRing(const std::shared_ptr<SampleRing> &ring);
+
+    /**
+     *  \brief      Records the device, or the monitor source of a sink.
+     *  \see        EventMonitor::OpenCapture
+     */
+    _Capture *OpenCapture(const pa_sample_spec &spec, uint32_t fragmentMs,
+        on_capture_data_cb_t callback, void *userdata);
+
+    /**
+     *  \brief      Starts reporting the EBU R128 loudness of the device
+     *  every intervalMs through the device callback of the EventMonitor.
+     *  Loudness meters are shared and reference counted.
+     *
+     *  \return     false if there is no EventMonitor or the stream could not
+     *  be created.
+     */
+    bool StartLoudness(uint32_t intervalMs);
+    void StopLoudness();
+
+    /**
+     *  \brief      Caps the volume of the device natively until the cap is
+     *  cleared with PA_VOLUME_INVALID or the device is removed.
+     *
+     *  \return     false if there is no EventMonitor to enforce the cap.
+     *  \see        EventMonitor::SetMaxVolume
+     */
+    bool SetMaxVolume(pa_volume_t max);
+
+    /**
+     *  \brief      Plays a sample of the server cache on an output device,
+     *  mixed by the server without any stream.
+     *
+     *  \param      volume  The volume of the sample, PA_VOLUME_INVALID for
+     *  the default one.
+     *  \return     false for an input device or an unknown sample.
+     *  \see        SoundMixer::UploadSample
+     */
+    bool PlaySample(const std::string &sample, pa_volume_t volume);
+
+    // the source recorded by the meter, the monitor source of a sink
+    virtual uint32_t MeterSource() = 0;
 };
 
 class OutputDevice : public _Device {
@@ -106,15 +316,21 @@ class OutputDevice : public _Device {
     std::vector<_AudioSession *> GetAudioSessions();
     float GetVolume();
     void SetVolume(float);
+    float StepVolume(float);
     bool GetMute();
     void SetMute(bool);
     void SetVolumeBalance(const VolumeBalance &);
     VolumeBalance GetVolumeBalance();
+    ChannelVolumes GetChannelVolumes();
+    void SetChannelVolumes(const ChannelVolumes &);
+    pa_cvolume GetRawVolume();
+    void SetRawVolume(const pa_cvolume &);
 
   public:
     std::string friendlyName();
     std::string name();
     DeviceType type();
+    uint32_t MeterSource();
 
   private:
     pa_sink_info *GetInfo();
@@ -132,28 +348,445 @@ class InputDevice : public _Device {
     std::vector<_AudioSession *> GetAudioSessions();
     float GetVolume();
     void SetVolume(float);
+    float StepVolume(float);
     bool GetMute();
     void SetMute(bool);
     void SetVolumeBalance(const VolumeBalance &);
     VolumeBalance GetVolumeBalance();
+    ChannelVolumes GetChannelVolumes();
+    void SetChannelVolumes(const ChannelVolumes &);
+    pa_cvolume GetRawVolume();
+    void SetRawVolume(const pa_cvolume &);
 
   public:
     std::string friendlyName();
     std::string name();
     DeviceType type();
+    uint32_t MeterSource();
 };
 
+typedef struct
+{
+    float volume;
+    bool mute;
+    DeviceDescriptor desc;
+    pa_cvolume cvolume;
+} _DeviceState;
+
+typedef struct
+{
+    float volume;
+    bool mute;
+    Subject subject;
+    pa_cvolume cvolume;
+    bool corked;
+    // last value sent with DEVICE_CHANGE_MASK_ACTIVE
+    bool active;
+} _SessionState;
+
+typedef struct
+{
+    pa_cvolume volume;
+    // pa_rtclock_now() when it was written
+    pa_usec_t at;
+} _WrittenVolume;
+
+typedef struct
+{
+    EventMonitor *monitor;
+    pa_stream *stream;
+    // number of StartMeter calls not yet matched by StopMeter
+    int refs;
+    Target target;
+    // the object reported to the device or session callback
+    DeviceDescriptor desc;
+    Subject subject;
+    // rings polled by JS, written on every reading
+    std::vector<std::shared_ptr<SampleRing>> rings;
+    // references held by silence detectors, which send no peak event
+    int detectors;
+    float threshold;
+    SoundMixerUtils::Clock::duration hold;
+    SoundMixerUtils::Clock::time_point lastSignal;
+} _Meter;
+
+typedef struct
+{
+    EventMonitor *monitor;
+    pa_stream *stream;
+    // number of StartLoudness calls not yet matched by StopLoudness
+    int refs;
+    Target target;
+    DeviceDescriptor desc;
+    Subject subject;
+    uint32_t intervalMs;
+    // created with the format of the source once the stream is ready
+    LoudnessMeter *meter;
+    // frames between two reports, and since the last one
+    uint32_t interval;
+    uint32_t pending;
+    // highest sample since the last report
+    float peak;
+} _Loudness;
+
+/**
+ *  \brief      Settings applied to the streams matching a rule as soon as
+ *  the server reports them.
+ */
+typedef struct
+{
+    // -1 matches both types
+    int type;
+    Matcher appName;
+    // PA_PROP_APPLICATION_PROCESS_BINARY and PA_PROP_MEDIA_ROLE
+    Matcher binary;
+    Matcher role;
+    // PA_VOLUME_INVALID when not set
+    pa_volume_t volume;
+    pa_volume_t maxVolume;
+    // -1 when not set
+    int mute;
+} SessionRule;
+
+typedef struct
+{
+    // the volume the session is restored to
+    pa_cvolume base;
+    // the last volume written, by the operation op
+    pa_cvolume applied;
+    pa_volume_t factor;
+    pa_operation *op;
+} _DuckedSession;
+
+typedef struct
+{
+    Selector trigger;
+    Selector target;
+    // attenuation in dB once fully ducked
+    double depth;
+    uint32_t attackMs;
+    uint32_t releaseMs;
+    // whether a trigger session is active
+    bool engaged;
+    // progress of the ramp, from 0 (restored) to 1 (fully ducked)
+    double level;
+    std::map<uint64_t, _DuckedSession> sessions;
+} _Ducker;
+
+/**
+ *  \brief      Watches the server for changes of sinks, sources and their
+ *  streams on its own connection, driven by a threaded mainloop.
+ *
+ *  \remarks    The mainloop used by SoundMixer is only iterated while a JS
+ *  call waits for an operation, so it cannot deliver subscription events.
+ */
+class EventMonitor {
+  public:
+    EventMonitor(on_device_changed_cb_t, on_session_changed_cb_t);
+    virtual ~EventMonitor();
+
+  public:
+    // invoked on the mainloop thread
+    void OnStateChange();
+    void OnEvent(pa_subscription_event_type_t type, uint32_t index);
+    void OnDeviceInfo(DeviceDescriptor desc, uint32_t index,
+        const pa_cvolume *volume, int mute);
+    void OnSessionInfo(Subject subject, uint32_t deviceIndex,
+        const pa_cvolume *volume, int mute, int corked);
+    void ApplyRules(const Subject &subject, pa_proplist *props,
+        pa_cvolume *volume, int *mute);
+
+  public:
+    /**
+     *  \brief      Steps the last volume written or seen for an object by
+     *  delta, and records the result as written.
+     *
+     *  \param      facility    The PA_SUBSCRIPTION_EVENT_* facility of the
+     *  object.
+     *  \param      index       The index of the object.
+     *  \param      out         The stepped volume to send.
+     *
+     *  \return     false if the object is unknown to the monitor.
+     *
+     *  \remarks    A written volume is stepped from until the server reports
+     *  it, so that back to back steps never start from the same stale
+     *  value. Must not be called from the mainloop thread.
+     */
+    bool StepVolume(
+        int facility, uint32_t index, float delta, pa_cvolume *out);
+
+    /**
+     *  \brief      Records a volume about to be sent for an object, the
+     *  base of the next StepVolume().
+     */
+    void WroteVolume(int facility, uint32_t index, const pa_cvolume &volume);
+
+    /**
+     *  \brief      Copies whether a session is active, that is uncorked and
+     *  not silenced by its detector.
+     *
+     *  \return     false if the session is unknown to the monitor.
+     */
+    bool LatestActive(int facility, uint32_t index, bool *out);
+
+    /**
+     *  \brief      Copies the names last seen for a session.
+     *
+     *  \return     false if the session is unknown to the monitor.
+     */
+    bool LatestSubject(int facility, uint32_t index, Subject *out);
+
+    /**
+     *  \brief      Replaces the rules applied to the streams created from
+     *  now on. The first matching rule sets the volume and mute of a stream
+     *  from the mainloop thread, before its creation reaches JS.
+     *
+     *  \remarks    Must not be called from the mainloop thread.
+     */
+    void SetRules(const std::vector<SessionRule> &rules);
+
+    /**
+     *  \brief      Keeps the loudest channel of a device or session at or
+     *  below max, PA_VOLUME_INVALID removing the limit. A volume above it
+     *  is scaled down right away, and so is every later change the server
+     *  reports above it, with a single write from the mainloop thread.
+     *
+     *  \remarks    The violating volume is not reported to the callbacks.
+     *  Must not be called from the mainloop thread.
+     */
+    void SetMaxVolume(Target target, pa_volume_t max);
+
+    /**
+     *  \brief      The sessions of the state cache matching a selector.
+     *
+     *  \remarks    Must not be called from the mainloop thread.
+     */
+    std::vector<Target> FindSessions(const Selector &selector);
+
+    /**
+     *  \brief      Lowers the sessions matching target by depth dB while
+     *  a session matching trigger is active, ramping the attenuation over
+     *  attackMs and back over releaseMs.
+     *
+     *  \return     The id of the ducker.
+     *
+     *  \remarks    Ramps are stepped by a timer of the mainloop, and start
+     *  from the activity change itself. A volume set on a ducked session by
+     *  anyone else becomes the volume it is restored to. Must not be called
+     *  from the mainloop thread.
+     */
+    int StartDucking(const Selector &trigger, const Selector &target,
+        double depth, uint32_t attackMs, uint32_t releaseMs);
+
+    /**
+     *  \brief      Restores the sessions of a ducker at once and removes it.
+     */
+    bool StopDucking(int id);
+
+    /**
+     *  \brief      Records the peaks of a source with PA_STREAM_PEAK_DETECT
+     *  and reports them through the device callback, flagged with
+     *  DEVICE_CHANGE_MASK_PEAK. Starting an existing meter only adds a
+     *  reference, keeping its rate.
+     *
+     *  \param      source  The index of the source to record.
+     *  \param      stream  The sink input to restrict the recording to with
+     *  pa_stream_set_monitor_stream, or PA_INVALID_INDEX.
+     *
+     *  \remarks    Session meters report through the session callback with
+     *  the last known subject of the session, and are released with it.
+     *  Must not be called from the mainloop thread.
+     */
+    bool StartMeter(Target target, DeviceDescriptor desc, uint32_t source,
+        uint32_t stream, uint32_t rateHz);
+    void StopMeter(Target target);
+
+    /**
+     *  \brief      Runs a low rate meter on a session and reports it through
+     *  the session callback, flagged with DEVICE_CHANGE_MASK_ACTIVE, as
+     *  inactive once its peaks have stayed below threshold for holdMs.
+     *  Sessions are always reported inactive while corked.
+     *
+     *  \remarks    Detectors share the meter of the session, the first one
+     *  setting the threshold. Must not be called from the mainloop thread.
+     */
+    bool StartSilenceDetector(Target target, uint32_t source, uint32_t stream,
+        float threshold, uint32_t holdMs);
+    void StopSilenceDetector(Target target);
+
+    std::shared_ptr<SampleRing> AttachMeterRing(
+        Target target, uint32_t capacity);
+    void DetachMeterRing(
+        Target target, const std::shared_ptr<SampleRing> &ring);
+
+    /**
+     *  \brief      Records a source, delivering its fragments to callback as
+     *  they are read.
+     *
+     *  \return     NULL if the stream could not be created, the capture is
+     *  owned by the monitor until given to CloseCapture.
+     *
+     *  \remarks    No callback is invoked once CloseCapture returns. Must
+     *  not be called from the mainloop thread.
+     */
+    _Capture *OpenCapture(uint32_t source, const pa_sample_spec &spec,
+        uint32_t fragmentMs, on_capture_data_cb_t callback, void *userdata);
+    void CloseCapture(_Capture *capture);
+
+    /**
+     *  \brief      Measures the loudness of a source at its own rate and
+     *  channel map, and reports it every intervalMs through the device
+     *  callback, flagged with DEVICE_CHANGE_MASK_LOUDNESS. Starting an
+     *  existing meter only adds a reference, keeping its interval.
+     *
+     *  \remarks    Same targets and restrictions as StartMeter.
+     */
+    bool StartLoudness(Target target, DeviceDescriptor desc, uint32_t source,
+        uint32_t stream, uint32_t intervalMs);
+    void StopLoudness(Target target);
+
+    // invoked on the mainloop thread
+    void OnPeak(_Meter *meter, float peak);
+    void OnLoudness(_Loudness *loudness);
+    void OnDuckTimer();
+
+  private:
+    void UpdateActivity(uint64_t key);
+    bool EnforceLimit(uint64_t key, Target target, const pa_cvolume *volume);
+    // drops the written volume of an object once the server reports it
+    void ForgetWritten(uint64_t key, const pa_cvolume *volume);
+    void UpdateDucking();
+    void ApplyDucking(_Ducker &ducker);
+    // whether a volume reported for a session is the ramp of a ducker
+    bool DuckingWrote(uint64_t key, const pa_cvolume *volume);
+    void RebaseDucked(uint64_t key, const pa_cvolume *volume);
+    void ReleaseMeter(uint64_t key);
+    void ReleaseCapture(_Capture *capture);
+    void ReleaseLoudness(uint64_t key);
+
+  private:
+    pa_threaded_mainloop *mainloop;
+    pa_context *ctx;
+    on_device_changed_cb_t deviceCallback;
+    on_session_changed_cb_t sessionCallback;
+    std::map<uint64_t, _DeviceState> devices;
+    std::map<uint64_t, _SessionState> sessions;
+    std::map<uint64_t, _Meter> meters;
+    std::vector<_Capture *> captures;
+    std::map<uint64_t, _Loudness> loudnessMeters;
+    std::vector<SessionRule> rules;
+    // volume caps of devices and sessions
+    std::map<uint64_t, pa_volume_t> limits;
+    // volumes sent by this process that the server has not reported yet
+    std::map<uint64_t, _WrittenVolume> written;
+    // streams announced by a NEW event whose info has not been received
+    std::set<uint64_t> created;
+    std::map<int, _Ducker> duckers;
+    int duckerCounter = 0;
+    // runs while a ducker ramps
+    pa_time_event *duckTimer = NULL;
+    SoundMixerUtils::Clock::time_point lastDuckTick;
+    int ready = 0;
+};
+
+/**
+ *  \brief      The volume and mute of a device or session, found being false
+ *  if the object does not exist.
+ */
+typedef struct
+{
+    pa_cvolume volume;
+    bool mute;
+    bool found;
+} VolumeState;
+
 class SoundMixer {
   public:
-    SoundMixer();
+    SoundMixer(on_device_changed_cb_t deviceCb = NULL,
+        on_session_changed_cb_t sessionCb = NULL);
     virtual ~SoundMixer();
     std::vector<_Device *> GetDevices();
     _Device *GetDefaultDevice(DeviceType);
+
+    /**
+     *  \brief      Makes a device the default of its type, optionally moving
+     *  every session of that type to it, in a single round trip.
+     *
+     *  \return     false if the server refused the new default or any of
+     *  the sessions to move.
+     */
+    bool SetDefaultDevice(_Device *device, bool moveSessions);
     _Device *GetDeviceByName(std::string name, DeviceType type);
+    _Device *GetDeviceByIndex(uint32_t index, DeviceType type);
+    _AudioSession *GetAudioSessionByIndex(uint32_t index, DeviceType type);
+
+    /**
+     *  \brief      Like GetAudioSessionByIndex, without any round trip when
+     *  the EventMonitor already knows the session.
+     */
+    _AudioSession *GetKnownAudioSession(uint32_t index, DeviceType type);
+
+    /**
+     *  \return     false if there is no EventMonitor to apply the rules.
+     *  \see        EventMonitor::SetRules
+     */
+    bool SetRules(const std::vector<SessionRule> &rules);
+
+    /**
+     *  \brief      Reads the volume and mute of several devices and
+     *  sessions in a single round trip, by sending every query before
+     *  waiting for the first one.
+     */
+    std::vector<VolumeState> GetVolumeStates(
+        const std::vector<Target> &targets);
+
+    /**
+     *  \brief      Writes the volume of several devices and sessions in a
+     *  single round trip. Volumes without channels are skipped.
+     */
+    void SetVolumes(const std::vector<Target> &targets,
+        const std::vector<pa_cvolume> &volumes);
+    void SetMutes(const std::vector<Target> &targets, bool mute);
+
+    /**
+     *  \brief      Moves sink inputs to a sink, or source outputs to a
+     *  source, sending every request before waiting for the first one.
+     *
+     *  \return     The number of sessions moved.
+     */
+    size_t MoveSessions(const std::vector<Target> &sessions, uint32_t device);
+
+    /**
+     *  \return     Nothing if there is no EventMonitor holding the sessions.
+     *  \see        EventMonitor::FindSessions
+     */
+    std::vector<Target> FindSessions(const Selector &selector);
+
+    /**
+     *  \brief      Uploads interleaved PCM to the sample cache of the
+     *  server, replacing any sample of the same name, so that it can be
+     *  played later without opening a stream.
+     *
+     *  \param      length  The size of data in bytes, a whole number of
+     *  frames of spec.
+     *  \return     false if the server refused the sample.
+     */
+    bool UploadSample(const std::string &name, const pa_sample_spec &spec,
+        const void *data, size_t length);
+    bool RemoveSample(const std::string &name);
+
+    /**
+     *  \return     -1 if there is no EventMonitor to run the ducker.
+     *  \see        EventMonitor::StartDucking
+     */
+    int StartDucking(const Selector &trigger, const Selector &target,
+        double depth, uint32_t attackMs, uint32_t releaseMs);
+    bool StopDucking(int id);
 
   private:
     _PAControls pa;
     int ready = 0;
+    EventMonitor *monitor = NULL;
 };
 
 }; // namespace LinuxSoundMixer
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cmath>
+#include "loudness.hpp"
+
+// steps of 100 ms in a momentary and in a short-term window
+#define MOMENTARY_STEPS 4
+#define SHORT_TERM_STEPS 30
+
+#define ABSOLUTE_GATE -70.
+#define RELATIVE_GATE -10.
+// histogram of the gating blocks, from the absolute gate to +5 LUFS
+#define HISTOGRAM_STEP 0.1
+#define HISTOGRAM_BINS 750
+
+namespace LinuxSoundMixer
+{
+
+static double _loudness(double power)
+{
+    return power > 0 ? -0.691 + 10 * std::log10(power) : -HUGE_VAL;
+}
+
+static double _channel_weight(pa_channel_position_t position)
+{
+    switch (position)
+    {
+        case PA_CHANNEL_POSITION_LFE:
+            return 0.;
+        case PA_CHANNEL_POSITION_SIDE_LEFT:
+        case PA_CHANNEL_POSITION_SIDE_RIGHT:
+        case PA_CHANNEL_POSITION_REAR_LEFT:
+        case PA_CHANNEL_POSITION_REAR_RIGHT:
+            return 1.41;
+        default:
+            return 1.;
+    }
+}
+
+LoudnessMeter::LoudnessMeter(
+    const pa_sample_spec &spec, const pa_channel_map *map)
+    : channels(spec.channels), stepFrames(std::max(spec.rate / 10, 1U)),
+      state(4 * (size_t)spec.channels), weights(spec.channels, 1.),
+      energy(spec.channels), blocks(HISTOGRAM_BINS),
+      blockPower(HISTOGRAM_BINS)
+{
+    // the filters of BS.1770, designed for any rate from their analog
+    // prototypes
+    double rate = spec.rate;
+    double k = std::tan(M_PI * 1681.974450955533 / rate);
+    double q = 0.7071752369554196;
+    double vh = std::pow(10., 3.999843853973347 / 20);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1 + k / q + k * k;
+    shelf = Biquad {{(vh + vb * k / q + k * k) / a0, 2 * (k * k - vh) / a0,
+                        (vh - vb * k / q + k * k) / a0},
+        {1., 2 * (k * k - 1) / a0, (1 - k / q + k * k) / a0}};
+
+    k = std::tan(M_PI * 38.13547087602444 / rate);
+    q = 0.5003270373238773;
+    a0 = 1 + k / q + k * k;
+    highPass = Biquad {
+        {1., -2., 1.}, {1., 2 * (k * k - 1) / a0, (1 - k / q + k * k) / a0}};
+
+    if (map != NULL && map->channels == channels)
+    {
+        for (uint8_t c = 0; c < channels; c++)
+            weights[c] = _channel_weight(map->map[c]);
+    }
+    std::fill(steps, steps + SHORT_TERM_STEPS, 0.);
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+}
+
+void LoudnessMeter::Feed(const float *samples, size_t count)
+{
+    while (count > 0)
+    {
+        size_t taken = std::min(count, (size_t)(stepFrames - frames));
+
+        // one channel at a time keeps the filter state in registers
+        for (uint8_t c = 0; c < channels; c++)
+        {
+            double *z = state.data() + 4 * c;
+            double z0 = z[0], z1 = z[1], z2 = z[2], z3 = z[3];
+            double sum = 0;
+            for (size_t i = 0; i < taken; i++)
+            {
+                double x = samples[i * channels + c];
+                // transposed direct form II
+                double y = shelf.b[0] * x + z0;
+                z0 = shelf.b[1] * x - shelf.a[1] * y + z1;
+                z1 = shelf.b[2] * x - shelf.a[2] * y;
+                double w = highPass.b[0] * y + z2;
+                z2 = highPass.b[1] * y - highPass.a[1] * w + z3;
+                z3 = highPass.b[2] * y - highPass.a[2] * w;
+                sum += w * w;
+            }
+            z[0] = z0, z[1] = z1, z[2] = z2, z[3] = z3;
+            energy[c] += sum;
+        }
+
+        samples += taken * channels;
+        count -= taken;
+        frames += (uint32_t)taken;
+        if (frames == stepFrames)
+            EndStep();
+    }
+}
+
+void LoudnessMeter::EndStep()
+{
+    double power = 0;
+    for (uint8_t c = 0; c < channels; c++)
+    {
+        power += weights[c] * energy[c] / stepFrames;
+        energy[c] = 0;
+    }
+    frames = 0;
+    steps[count++ % SHORT_TERM_STEPS] = power;
+    if (count < MOMENTARY_STEPS)
+        return;
+
+    // a gating block ends with every step
+    double block = 0;
+    for (uint64_t s = count - MOMENTARY_STEPS; s < count; s++)
+        block += steps[s % SHORT_TERM_STEPS];
+    block /= MOMENTARY_STEPS;
+    double loudness = _loudness(block);
+    if (loudness > ABSOLUTE_GATE)
+    {
+        size_t bin = std::min((size_t)((loudness - ABSOLUTE_GATE)
+                                  / HISTOGRAM_STEP),
+            (size_t)HISTOGRAM_BINS - 1);
+        blocks[bin]++;
+        blockPower[bin] += block;
+    }
+}
+
+LoudnessReading LoudnessMeter::Read()
+{
+    LoudnessReading reading {-HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+    double sum = 0;
+    for (uint64_t s = 0; s < std::min(count, (uint64_t)SHORT_TERM_STEPS);
+         s++)
+    {
+        sum += steps[(count - 1 - s) % SHORT_TERM_STEPS];
+        if (s + 1 == MOMENTARY_STEPS)
+            reading.momentary = _loudness(sum / MOMENTARY_STEPS);
+    }
+    if (count >= SHORT_TERM_STEPS)
+        reading.shortTerm = _loudness(sum / SHORT_TERM_STEPS);
+
+    uint64_t total = 0;
+    double power = 0;
+    for (size_t bin = 0; bin < HISTOGRAM_BINS; bin++)
+    {
+        total += blocks[bin];
+        power += blockPower[bin];
+    }
+    if (total == 0)
+        return reading;
+
+    // blocks of the bins centred above the relative gate
+    double gate = _loudness(power / total) + RELATIVE_GATE;
+    total = 0;
+    power = 0;
+    for (size_t bin = 0; bin < HISTOGRAM_BINS; bin++)
+    {
+        if (ABSOLUTE_GATE + (bin + 0.5) * HISTOGRAM_STEP > gate)
+        {
+            total += blocks[bin];
+            power += blockPower[bin];
+        }
+    }
+    if (total > 0)
+        reading.integrated = _loudness(power / total);
+
+    return reading;
+}
+
+} // namespace LinuxSoundMixer
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <pulse/pulseaudio.h>
+#include <vector>
+
+namespace LinuxSoundMixer
+{
+
+/**
+ *  \brief      Loudness readings in LUFS, -HUGE_VAL until enough audio has
+ *  been measured or while the signal is silent.
+ */
+typedef struct
+{
+    // the last 400 ms
+    double momentary;
+    // the last 3 s
+    double shortTerm;
+    // gated over everything measured since the meter was created
+    double integrated;
+} LoudnessReading;
+
+/**
+ *  \brief      EBU R128 loudness meter of an interleaved float stream, as
+ *  specified by ITU-R BS.1770-4.
+ *
+ *  \remarks    Samples are K-weighted with two biquads per channel and their
+ *  energy summed in 100 ms steps, from which the 400 ms gating blocks
+ *  overlap by 75%. Gating blocks are kept in a 0.1 LU histogram, so that
+ *  the memory of the integrated loudness does not grow with time, the
+ *  relative gate being resolved to the nearest bin.
+ */
+class LoudnessMeter {
+  public:
+    /**
+     *  \param      spec    The sample spec of the stream, only its rate and
+     *  channel count are used.
+     *  \param      map     The channel map weighting the channels, the
+     *  LFE being ignored and surround channels weighing 1.41. May be NULL.
+     */
+    LoudnessMeter(const pa_sample_spec &spec, const pa_channel_map *map);
+    virtual ~LoudnessMeter();
+
+    void Feed(const float *samples, size_t frames);
+    LoudnessReading Read();
+
+  private:
+    void EndStep();
+
+  private:
+    typedef struct
+    {
+        double b[3];
+        double a[3];
+    } Biquad;
+
+    uint8_t channels;
+    uint32_t stepFrames;
+    uint32_t frames = 0;
+    Biquad shelf;
+    Biquad highPass;
+    // two delay elements per filter and channel
+    std::vector<double> state;
+    std::vector<double> weights;
+    std::vector<double> energy;
+
+    // mean square of the last 30 steps, newest at steps[count % 30]
+    double steps[30];
+    uint64_t count = 0;
+
+    std::vector<uint64_t> blocks;
+    std::vector<double> blockPower;
+};
+
+} // namespace LinuxSoundMixer
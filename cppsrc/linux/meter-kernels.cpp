@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "meter-kernels.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define METER_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+// blocks accumulated in single precision before being folded into doubles
+#define FLUSH_BLOCKS 256
+
+namespace LinuxSoundMixer
+{
+
+typedef struct
+{
+    uint8_t channels;
+    float peak[PA_CHANNELS_MAX];
+    double squares[PA_CHANNELS_MAX];
+    uint32_t clipped[PA_CHANNELS_MAX];
+} _Sums;
+
+static inline float _sample(float sample)
+{
+    return sample;
+}
+
+static inline float _sample(int16_t sample)
+{
+    return sample * (1.F / 32768);
+}
+
+template <typename T>
+static void _measure_scalar(
+    const T *samples, size_t count, float clip, _Sums *sums)
+{
+    uint8_t channel = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        float value = _sample(samples[i]);
+        float magnitude = std::fabs(value);
+        sums->peak[channel] = std::max(sums->peak[channel], magnitude);
+        sums->squares[channel] += (double)value * value;
+        sums->clipped[channel] += magnitude >= clip;
+        if (++channel == sums->channels)
+            channel = 0;
+    }
+}
+
+/**
+ *  \brief      Folds the lanes of the vector accumulators into the channel
+ *  sums. A block covers whole frames, so lane i holds channel
+ *  i % channels.
+ */
+static void _fold(const float *peak, const float *squares,
+    const int32_t *clipped, size_t lanes, _Sums *sums)
+{
+    for (size_t i = 0; i < lanes; i++)
+    {
+        uint8_t channel = i % sums->channels;
+        sums->peak[channel] = std::max(sums->peak[channel], peak[i]);
+        sums->squares[channel] += squares[i];
+        sums->clipped[channel] += clipped[i];
+    }
+}
+
+#ifdef METER_KERNELS_X86
+
+__attribute__((target("sse2"))) static inline __m128 _load_sse2(
+    const float *samples)
+{
+    return _mm_loadu_ps(samples);
+}
+
+__attribute__((target("sse2"))) static inline __m128 _load_sse2(
+    const int16_t *samples)
+{
+    __m128i v = _mm_loadl_epi64((const __m128i *)samples);
+    // sign extends the four samples to 32 bits
+    v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.F / 32768));
+}
+
+/**
+ *  \brief      Processes blocks of `channels` vectors, that is 4 frames, with
+ *  one set of accumulators per vector of the block.
+ *
+ *  \return     The number of samples processed, the tail being left to the
+ *  scalar kernel.
+ */
+template <typename T>
+__attribute__((target("sse2"))) static size_t _measure_sse2(
+    const T *samples, size_t count, float clip, _Sums *sums)
+{
+    const size_t lanes = 4 * sums->channels;
+    const size_t blocks = count / lanes;
+    const __m128 sign = _mm_set1_ps(-0.F);
+    const __m128 limit = _mm_set1_ps(clip);
+    __m128 peak[PA_CHANNELS_MAX];
+    __m128 squares[PA_CHANNELS_MAX];
+    __m128i clipped[PA_CHANNELS_MAX];
+    float peakLanes[4 * PA_CHANNELS_MAX];
+    float squareLanes[4 * PA_CHANNELS_MAX];
+    int32_t clipLanes[4 * PA_CHANNELS_MAX];
+
+    for (size_t b = 0; b < blocks;)
+    {
+        for (uint8_t k = 0; k < sums->channels; k++)
+        {
+            peak[k] = _mm_setzero_ps();
+            squares[k] = _mm_setzero_ps();
+            clipped[k] = _mm_setzero_si128();
+        }
+
+        for (size_t end = std::min(blocks, b + FLUSH_BLOCKS); b < end; b++)
+        {
+            const T *block = samples + b * lanes;
+            for (uint8_t k = 0; k < sums->channels; k++)
+            {
+                __m128 v = _load_sse2(block + 4 * k);
+                __m128 magnitude = _mm_andnot_ps(sign, v);
+                peak[k] = _mm_max_ps(peak[k], magnitude);
+                squares[k] = _mm_add_ps(squares[k], _mm_mul_ps(v, v));
+                // clipped lanes compare to -1
+                clipped[k] = _mm_sub_epi32(clipped[k],
+                    _mm_castps_si128(_mm_cmpge_ps(magnitude, limit)));
+            }
+        }
+
+        for (uint8_t k = 0; k < sums->channels; k++)
+        {
+            _mm_storeu_ps(peakLanes + 4 * k, peak[k]);
+            _mm_storeu_ps(squareLanes + 4 * k, squares[k]);
+            _mm_storeu_si128((__m128i *)(clipLanes + 4 * k), clipped[k]);
+        }
+        _fold(peakLanes, squareLanes, clipLanes, lanes, sums);
+    }
+
+    return blocks * lanes;
+}
+
+__attribute__((target("avx2"))) static inline __m256 _load_avx2(
+    const float *samples)
+{
+    return _mm256_loadu_ps(samples);
+}
+
+__attribute__((target("avx2"))) static inline __m256 _load_avx2(
+    const int16_t *samples)
+{
+    __m256i v = _mm256_cvtepi16_epi32(
+        _mm_loadu_si128((const __m128i *)samples));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.F / 32768));
+}
+
+/**
+ *  \brief      The 8 frames wide version of _measure_sse2.
+ */
+template <typename T>
+__attribute__((target("avx2"))) static size_t _measure_avx2(
+    const T *samples, size_t count, float clip, _Sums *sums)
+{
+    const size_t lanes = 8 * sums->channels;
+    const size_t blocks = count / lanes;
+    const __m256 sign = _mm256_set1_ps(-0.F);
+    const __m256 limit = _mm256_set1_ps(clip);
+    __m256 peak[PA_CHANNELS_MAX];
+    __m256 squares[PA_CHANNELS_MAX];
+    __m256i clipped[PA_CHANNELS_MAX];
+    float peakLanes[8 * PA_CHANNELS_MAX];
+    float squareLanes[8 * PA_CHANNELS_MAX];
+    int32_t clipLanes[8 * PA_CHANNELS_MAX];
+
+    for (size_t b = 0; b < blocks;)
+    {
+        for (uint8_t k = 0; k < sums->channels; k++)
+        {
+            peak[k] = _mm256_setzero_ps();
+            squares[k] = _mm256_setzero_ps();
+            clipped[k] = _mm256_setzero_si256();
+        }
+
+        for (size_t end = std::min(blocks, b + FLUSH_BLOCKS); b < end; b++)
+        {
+            const T *block = samples + b * lanes;
+            for (uint8_t k = 0; k < sums->channels; k++)
+            {
+                __m256 v = _load_avx2(block + 8 * k);
+                __m256 magnitude = _mm256_andnot_ps(sign, v);
+                peak[k] = _mm256_max_ps(peak[k], magnitude);
+                squares[k] = _mm256_add_ps(squares[k], _mm256_mul_ps(v, v));
+                clipped[k] = _mm256_sub_epi32(clipped[k],
+                    _mm256_castps_si256(
+                        _mm256_cmp_ps(magnitude, limit, _CMP_GE_OQ)));
+            }
+        }
+
+        for (uint8_t k = 0; k < sums->channels; k++)
+        {
+            _mm256_storeu_ps(peakLanes + 8 * k, peak[k]);
+            _mm256_storeu_ps(squareLanes + 8 * k, squares[k]);
+            _mm256_storeu_si256((__m256i *)(clipLanes + 8 * k), clipped[k]);
+        }
+        _fold(peakLanes, squareLanes, clipLanes, lanes, sums);
+    }
+
+    return blocks * lanes;
+}
+
+#endif
+
+template <typename T>
+static void _measure(const T *samples, size_t count, float clip,
+    MeterKernel kernel, _Sums *sums)
+{
+    size_t done = 0;
+#ifdef METER_KERNELS_X86
+    if (kernel == KERNEL_AVX2)
+        done = _measure_avx2(samples, count, clip, sums);
+    else if (kernel == KERNEL_SSE2)
+        done = _measure_sse2(samples, count, clip, sums);
+#endif
+    _measure_scalar(samples + done, count - done, clip, sums);
+}
+
+static MeterKernel _detect_kernel()
+{
+#ifdef METER_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return KERNEL_SSE2;
+#endif
+    return KERNEL_SCALAR;
+}
+
+MeterKernel BestMeterKernel()
+{
+    static const MeterKernel best = _detect_kernel();
+    return best;
+}
+
+const char *MeterKernelName(MeterKernel kernel)
+{
+    switch (kernel)
+    {
+        case KERNEL_SCALAR:
+            return "scalar";
+        case KERNEL_SSE2:
+            return "sse2";
+        case KERNEL_AVX2:
+            return "avx2";
+        default:
+            return MeterKernelName(BestMeterKernel());
+    }
+}
+
+bool MeasureLevels(const pa_sample_spec &spec, const void *data,
+    size_t length, ChannelLevels *out, MeterKernel kernel)
+{
+    if (spec.channels == 0 || spec.channels > PA_CHANNELS_MAX)
+    {
+        return false;
+    }
+
+    // every kernel supported by the CPU is at most as wide as the best one
+    if (kernel == KERNEL_AUTO || kernel > BestMeterKernel())
+    {
+        kernel = BestMeterKernel();
+    }
+
+    _Sums sums;
+    std::memset(&sums, 0, sizeof(sums));
+    sums.channels = spec.channels;
+    size_t frames;
+    switch (spec.format)
+    {
+        case PA_SAMPLE_FLOAT32NE:
+            frames = length / (sizeof(float) * spec.channels);
+            _measure((const float *)data, frames * spec.channels, 1.F, kernel,
+                &sums);
+            break;
+        case PA_SAMPLE_S16NE:
+            frames = length / (sizeof(int16_t) * spec.channels);
+            _measure((const int16_t *)data, frames * spec.channels,
+                32767.F / 32768, kernel, &sums);
+            break;
+        default:
+            return false;
+    }
+
+    out->channels = spec.channels;
+    out->frames = (uint32_t)frames;
+    for (uint8_t c = 0; c < spec.channels; c++)
+    {
+        out->peak[c] = sums.peak[c];
+        out->rms[c]
+            = frames > 0 ? (float)std::sqrt(sums.squares[c] / frames) : 0.F;
+        out->clipped[c] = sums.clipped[c];
+    }
+
+    return true;
+}
+
+} // namespace LinuxSoundMixer
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <pulse/pulseaudio.h>
+
+namespace LinuxSoundMixer
+{
+
+/**
+ *  \brief      The implementations of MeasureLevels, KERNEL_AUTO picking the
+ *  fastest one supported by the CPU.
+ */
+enum MeterKernel
+{
+    KERNEL_AUTO = 0,
+    KERNEL_SCALAR = 1,
+    KERNEL_SSE2 = 2,
+    KERNEL_AVX2 = 3
+};
+
+/**
+ *  \brief      Levels of every channel of a buffer, samples being scaled to
+ *  [-1, 1].
+ */
+typedef struct
+{
+    uint8_t channels;
+    uint32_t frames;
+    float peak[PA_CHANNELS_MAX];
+    float rms[PA_CHANNELS_MAX];
+    // samples at full scale, for S16 either -32768 or 32767
+    uint32_t clipped[PA_CHANNELS_MAX];
+} ChannelLevels;
+
+/**
+ *  \brief      The kernel KERNEL_AUTO resolves to, detected once.
+ */
+MeterKernel BestMeterKernel();
+const char *MeterKernelName(MeterKernel kernel);
+
+/**
+ *  \brief      Computes the peak, RMS and clip count of every channel of an
+ *  interleaved buffer in one pass.
+ *
+ *  \param      spec    The sample spec of the buffer, only
+ *  PA_SAMPLE_FLOAT32NE and PA_SAMPLE_S16NE are supported.
+ *  \param      length  The size of the buffer in bytes, a trailing partial
+ *  frame is ignored.
+ *  \param      kernel  The implementation to use, falling back to
+ *  BestMeterKernel() if the CPU does not support it.
+ *
+ *  \return     false if the format is not supported.
+ */
+bool MeasureLevels(const pa_sample_spec &spec, const void *data,
+    size_t length, ChannelLevels *out, MeterKernel kernel = KERNEL_AUTO);
+
+} // namespace LinuxSoundMixer
@@ -0,0 +1,54 @@
+#include <cstring>
+#include <new>
+#include "sample-ring.hpp"
+
+static_assert(sizeof(LinuxSoundMixer::RingHeader) == 4 * sizeof(uint32_t),
+    "the ring header is read by JS as four 32 bits words");
+
+namespace LinuxSoundMixer
+{
+
+SampleRing::SampleRing(uint32_t capacity, uint32_t width)
+{
+    size_t words = 4 + (size_t)capacity * width;
+    size = words * sizeof(uint32_t);
+    memory = new uint32_t[words]();
+
+    header = new (memory) RingHeader();
+    header->capacity = capacity;
+    header->width = width;
+    slots = reinterpret_cast<float *>(memory + 4);
+}
+
+SampleRing::~SampleRing()
+{
+    header->~RingHeader();
+    delete[] memory;
+}
+
+void SampleRing::Push(const float *values)
+{
+    uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t written = header->written.load(std::memory_order_relaxed);
+    size_t slot = written % header->capacity;
+    std::memcpy(slots + slot * header->width, values,
+        header->width * sizeof(float));
+    header->written.store(written + 1, std::memory_order_relaxed);
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void *SampleRing::Data()
+{
+    return memory;
+}
+
+size_t SampleRing::Size()
+{
+    return size;
+}
+
+} // namespace LinuxSoundMixer
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace LinuxSoundMixer
+{
+
+/**
+ *  \brief      Header of a SampleRing, read by JS as the first four words
+ *  of a Uint32Array.
+ *
+ *  \remarks    sequence is odd while a slot is being written. A reader
+ *  reads it, then the slots, then reads it again and retries if it was odd
+ *  or changed in between.
+ */
+typedef struct
+{
+    std::atomic<uint32_t> sequence;
+    // slots ever written, the latest one is (written - 1) % capacity
+    std::atomic<uint32_t> written;
+    uint32_t capacity;
+    // number of floats per slot
+    uint32_t width;
+} RingHeader;
+
+/**
+ *  \brief      Single producer ring of fixed width float slots, guarded by a
+ *  seqlock so that it can be polled from JS without any callback.
+ *
+ *  \remarks    Push() must only be called from one thread at a time.
+ */
+class SampleRing {
+  public:
+    SampleRing(uint32_t capacity, uint32_t width);
+    virtual ~SampleRing();
+
+    void Push(const float *values);
+
+    // the header followed by the slots
+    void *Data();
+    size_t Size();
+
+  private:
+    SampleRing(const SampleRing &);
+    SampleRing &operator=(const SampleRing &);
+
+    uint32_t *memory;
+    size_t size;
+    RingHeader *header;
+    float *slots;
+};
+
+} // namespace LinuxSoundMixer
@@ -1,3 +1,4 @@
+#include <cmath>
 #include <iostream>
 #include <string>
 #include "sound-mixer-utils.hpp"
@@ -48,6 +49,399 @@ uint32_t combine_hashes(DeviceDescriptor device, EventType type)
     return hashcode(device) ^ typeval;
 }
 
+PropertyKeys *InitPropertyKeys(Napi::Env env)
+{
+    PropertyKeys *keys = new PropertyKeys();
+    keys->right = Napi::Persistent(Napi::String::New(env, "right"));
+    keys->left = Napi::Persistent(Napi::String::New(env, "left"));
+    keys->stereo = Napi::Persistent(Napi::String::New(env, "stereo"));
+    keys->positions = Napi::Persistent(Napi::String::New(env, "positions"));
+    keys->volumes = Napi::Persistent(Napi::String::New(env, "volumes"));
+    keys->momentary = Napi::Persistent(Napi::String::New(env, "momentary"));
+    keys->shortTerm = Napi::Persistent(Napi::String::New(env, "shortTerm"));
+    keys->integrated
+        = Napi::Persistent(Napi::String::New(env, "integrated"));
+    keys->samplePeak
+        = Napi::Persistent(Napi::String::New(env, "samplePeak"));
+    keys->hits = Napi::Persistent(Napi::String::New(env, "hits"));
+    keys->misses = Napi::Persistent(Napi::String::New(env, "misses"));
+    env.SetInstanceData<PropertyKeys>(keys);
+    return keys;
+}
+
+PropertyKeys *GetPropertyKeys(Napi::Env env)
+{
+    return env.GetInstanceData<PropertyKeys>();
+}
+
+void AliasDisposeSymbol(Napi::Function cls)
+{
+    Napi::Env env = cls.Env();
+    Napi::Value symbol
+        = env.Global().Get("Symbol").As<Napi::Object>().Get("dispose");
+    if (!symbol.IsSymbol())
+        return;
+
+    Napi::Object proto = cls.Get("prototype").As<Napi::Object>();
+    proto.Set(symbol, proto.Get("dispose"));
+}
+
+#define POOL_NIL 0xFFFFFFFFU
+#define POOL_INDEX(head) ((uint32_t)((head)&0xFFFFFFFFU))
+#define POOL_TAG(head) ((head) >> 32)
+
+NotificationPool notificationPool;
+target_resolver_t targetResolver = NULL;
+
+NotificationPool::NotificationPool() : head(0), hits(0), misses(0)
+{
+    for (uint32_t i = 0; i < NOTIFICATION_POOL_SIZE; i++)
+    {
+        next[i].store(i + 1 < NOTIFICATION_POOL_SIZE ? i + 1 : POOL_NIL);
+    }
+}
+
+NotificationHandler *NotificationPool::Acquire()
+{
+    uint64_t old = head.load(std::memory_order_acquire);
+    while (POOL_INDEX(old) != POOL_NIL)
+    {
+        uint32_t index = POOL_INDEX(old);
+        uint64_t desired = ((POOL_TAG(old) + 1) << 32)
+            | next[index].load(std::memory_order_relaxed);
+        if (head.compare_exchange_weak(old, desired,
+                std::memory_order_acquire, std::memory_order_acquire))
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return &slots[index];
+        }
+    }
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return new NotificationHandler();
+}
+
+void NotificationPool::Release(NotificationHandler *data)
+{
+    uintptr_t addr = reinterpret_cast<uintptr_t>(data);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(slots);
+    uintptr_t end
+        = reinterpret_cast<uintptr_t>(slots + NOTIFICATION_POOL_SIZE);
+    if (addr < begin || addr >= end)
+    {
+        delete data;
+        return;
+    }
+
+    uint32_t index = (uint32_t)(data - slots);
+    uint64_t old = head.load(std::memory_order_relaxed);
+    uint64_t desired;
+    do
+    {
+        next[index].store(POOL_INDEX(old), std::memory_order_relaxed);
+        desired = ((POOL_TAG(old) + 1) << 32) | index;
+    } while (!head.compare_exchange_weak(
+        old, desired, std::memory_order_release, std::memory_order_relaxed));
+}
+
+NotificationPoolStats NotificationPool::Stats()
+{
+    return NotificationPoolStats {
+        hits.load(std::memory_order_relaxed),
+        misses.load(std::memory_order_relaxed),
+    };
+}
+
+bool ParseListenerOptions(
+    Napi::Env env, Napi::Value value, ListenerOptions *options)
+{
+    *options = ListenerOptions {0, 0, true, true};
+    if (value.IsUndefined() || value.IsNull())
+    {
+        return true;
+    }
+    if (!value.IsObject())
+    {
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object param = value.As<Napi::Object>();
+    const char *rates[] = {"maxRate", "debounceMs"};
+    double *targets[] = {&options->maxRate, &options->debounceMs};
+    for (size_t i = 0; i < 2; i++)
+    {
+        Napi::Value v = param.Get(rates[i]);
+        if (v.IsUndefined())
+            continue;
+        double d = v.IsNumber() ? v.As<Napi::Number>().DoubleValue() : NAN;
+        // the window of the gate in microseconds, which must not round
+        // down to nothing
+        double window = i == 0 ? 1e6 / d : d * 1e3;
+        if (!std::isfinite(d) || d < 0 || (d > 0 && window < 1))
+        {
+            Napi::Error::New(env,
+                std::string("Expected <") + rates[i]
+                    + "> to be a positive number within limits")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        *targets[i] = d;
+    }
+
+    // like a lodash debounce, a debounced listener skips the leading edge
+    // unless asked otherwise.
+    options->leading = options->debounceMs == 0;
+    if (param.Has("leading"))
+        options->leading = param.Get("leading").ToBoolean().Value();
+    if (param.Has("trailing"))
+        options->trailing = param.Get("trailing").ToBoolean().Value();
+
+    if (!options->leading && !options->trailing)
+    {
+        Napi::Error::New(env, "<leading> and <trailing> cannot both be false")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return true;
+}
+
+EventGate::EventGate() : hasMaxWait(false), leading(true), trailing(true)
+{
+}
+
+EventGate::EventGate(ListenerOptions options)
+    : hasMaxWait(options.maxRate > 0), leading(options.leading),
+      trailing(options.trailing)
+{
+    if (options.maxRate > 0)
+    {
+        maxWait = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::microseconds(std::llround(1e6 / options.maxRate)));
+    }
+
+    if (options.debounceMs > 0)
+        wait = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::microseconds(std::llround(options.debounceMs * 1e3)));
+    else
+        wait = maxWait;
+}
+
+bool EventGate::Enabled()
+{
+    return wait.count() > 0;
+}
+
+bool EventGate::Push(Clock::time_point now, const NotificationHandler &data)
+{
+    if (!Enabled())
+    {
+        return true;
+    }
+
+    bool emit = false;
+    if (!active)
+    {
+        bool limited = invoked && hasMaxWait && now - lastInvoke < maxWait;
+        active = true;
+        if (leading && !limited)
+        {
+            emit = true;
+            invoked = true;
+            lastInvoke = now;
+        }
+        else
+        {
+            // an edge held back by the rate limit is delivered at the end of
+            // the current window.
+            last = data;
+            pending = true;
+            if (!limited)
+                lastInvoke = now;
+        }
+    }
+    else
+    {
+        last = data;
+        pending = pending || trailing;
+        if (hasMaxWait && now - lastInvoke >= maxWait)
+        {
+            emit = true;
+            pending = false;
+            invoked = true;
+            lastInvoke = now;
+        }
+    }
+    lastEvent = now;
+
+    return emit;
+}
+
+bool EventGate::Flush(Clock::time_point now, NotificationHandler *out)
+{
+    if (!active)
+    {
+        return false;
+    }
+
+    bool quiet = now - lastEvent >= wait;
+    bool due = pending && hasMaxWait && now - lastInvoke >= maxWait;
+    if (quiet)
+        active = false;
+    if (!pending || (!quiet && !due))
+        return false;
+
+    pending = false;
+    invoked = true;
+    lastInvoke = now;
+    *out = last;
+    return true;
+}
+
+bool EventGate::Deadline(Clock::time_point *out)
+{
+    if (!active)
+    {
+        return false;
+    }
+
+    *out = lastEvent + wait;
+    if (pending && hasMaxWait && lastInvoke + maxWait < *out)
+        *out = lastInvoke + maxWait;
+    return true;
+}
+
+Matcher::Matcher() : any(true)
+{
+}
+
+Matcher::Matcher(const std::string &value) : any(false), value(value)
+{
+}
+
+Matcher::Matcher(const std::string &pattern, bool icase) : any(false)
+{
+    std::regex::flag_type flags = std::regex::ECMAScript;
+    if (icase)
+        flags |= std::regex::icase;
+    regex = std::make_shared<std::regex>(pattern, flags);
+}
+
+bool Matcher::Match(const std::string &v) const
+{
+    if (any)
+        return true;
+    if (regex)
+        return std::regex_search(v, *regex);
+    return v == value;
+}
+
+bool ParseMatcher(
+    Napi::Env env, Napi::Object param, const char *key, Matcher *out)
+{
+    Napi::Value v = param.Get(key);
+    if (v.IsUndefined())
+    {
+        return true;
+    }
+    if (v.IsString())
+    {
+        *out = Matcher(v.As<Napi::String>().Utf8Value());
+        return true;
+    }
+
+    Napi::Function regExp = env.Global().Get("RegExp").As<Napi::Function>();
+    if (v.IsObject() && v.As<Napi::Object>().InstanceOf(regExp))
+    {
+        Napi::Object re = v.As<Napi::Object>();
+        std::string flags = re.Get("flags").ToString().Utf8Value();
+        try
+        {
+            *out = Matcher(re.Get("source").ToString().Utf8Value(),
+                flags.find('i') != std::string::npos);
+            return true;
+        }
+        catch (const std::regex_error &)
+        {
+            Napi::Error::New(env,
+                std::string("Unsupported regular expression for <") + key
+                    + ">")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    Napi::Error::New(env,
+        std::string("Expected <") + key + "> to be a string or a RegExp")
+        .ThrowAsJavaScriptException();
+    return false;
+}
+
+bool ParseSelector(Napi::Env env, Napi::Value value, Selector *selector)
+{
+    *selector = Selector {TARGET_NONE, -1, Matcher(), Matcher(), Matcher()};
+    if (!value.IsObject())
+    {
+        Napi::Error::New(env, "Expected <selector> to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object param = value.As<Napi::Object>();
+    Napi::Value kind = param.Get("type");
+    if (kind.IsString())
+    {
+        std::string name = kind.As<Napi::String>().Utf8Value();
+        if (name == "device")
+            selector->kind = TARGET_DEVICE;
+        else if (name == "session")
+            selector->kind = TARGET_SESSION;
+    }
+    if (!kind.IsUndefined() && selector->kind == TARGET_NONE)
+    {
+        Napi::Error::New(env, "Expected <type> to be 'device' or 'session'")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Value type = param.Get("deviceType");
+    if (type.IsNumber())
+    {
+        selector->type = type.As<Napi::Number>().Int32Value();
+    }
+
+    return ParseMatcher(env, param, "name", &selector->name)
+        && ParseMatcher(env, param, "appName", &selector->appName)
+        && ParseMatcher(env, param, "device", &selector->device);
+}
+
+bool selectorMatches(const Selector &selector, const Subject &subject)
+{
+    if (selector.kind != TARGET_NONE && selector.kind != subject.target.kind)
+        return false;
+    if (selector.type >= 0 && selector.type != (int)subject.target.type)
+        return false;
+    return selector.name.Match(subject.name)
+        && selector.appName.Match(subject.appName)
+        && selector.device.Match(subject.device);
+}
+
+static uint64_t targetKey(Target target)
+{
+    return ((uint64_t)target.kind << 40) | ((uint64_t)target.type << 32)
+        | target.index;
+}
+
+static void emit(TSFN func, const NotificationHandler &data)
+{
+    NotificationHandler *pData = notificationPool.Acquire();
+    *pData = data;
+    if (func.NonBlockingCall(pData) != napi_ok)
+        notificationPool.Release(pData);
+}
+
 EventPool::EventPool() : counter(0)
 {
 }
@@ -55,34 +449,41 @@ EventPool::EventPool() : counter(0)
 EventPool::~EventPool()
 {
     Clear();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cond.notify_all();
+    if (m_flusher.joinable())
+        m_flusher.join();
 }
 
-int EventPool::RegisterEvent(
-    DeviceDescriptor device, EventType type, TSFN func)
+int EventPool::RegisterEvent(DeviceDescriptor device, EventType type,
+    TSFN func, ListenerOptions options)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     uint32_t key = combine_hashes(device, type);
-    if (m_events.count(key) <= 0)
-    {
-        std::map<int, TSFN> res;
-        res[counter] = func;
-        m_events[key] = res;
-    }
-    else
+    Listener listener {func, EventGate(options)};
+    m_events[key][counter] = listener;
+
+    if (listener.gate.Enabled() && !m_flusher.joinable())
     {
-        m_events[key][counter] = func;
+        m_flusher = std::thread(&EventPool::FlushLoop, this);
     }
     return counter++;
 }
 
 bool EventPool::RemoveEvent(DeviceDescriptor device, EventType type, int id)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     uint32_t key = combine_hashes(device, type);
     if (m_events.count(key) <= 0)
         return false;
 
     if (m_events[key].count(id) > 0)
     {
-        m_events[key][id].Release();
+        m_events[key][id].func.Release();
         return m_events[key].erase(id) > 0;
     }
     else
@@ -94,14 +495,15 @@ bool EventPool::RemoveEvent(DeviceDescriptor device, EventType type, int id)
 std::vector<TSFN> EventPool::GetListeners(
     DeviceDescriptor device, EventType type)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     uint32_t key = combine_hashes(device, type);
     std::vector<TSFN> res;
     if (m_events.count(key) <= 0)
         return res;
-    std::map<int, TSFN> contained = m_events[key];
+    std::map<int, Listener> &contained = m_events[key];
     for (auto it = contained.begin(); it != contained.end(); ++it)
     {
-        res.push_back(it->second);
+        res.push_back(it->second.func);
     }
 
     return res;
@@ -109,36 +511,223 @@ std::vector<TSFN> EventPool::GetListeners(
 
 void EventPool::RemoveAllListeners(DeviceDescriptor device, EventType type)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     uint32_t key = combine_hashes(device, type);
-    std::map<int, TSFN> contained = m_events[key];
+    std::map<int, Listener> &contained = m_events[key];
     for (auto it = contained.begin(); it != contained.end(); ++it)
     {
-        it->second.Release();
+        it->second.func.Release();
     }
     m_events.erase(key);
 }
 
 void EventPool::Clear()
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     for (auto it1 = m_events.begin(); it1 != m_events.end(); ++it1)
     {
-        std::map<int, TSFN> el = it1->second;
+        std::map<int, Listener> &el = it1->second;
+        for (auto it2 = el.begin(); it2 != el.end(); ++it2)
+        {
+            it2->second.func.Release();
+        }
+    }
+    for (auto it1 = m_selectors.begin(); it1 != m_selectors.end(); ++it1)
+    {
+        std::map<int, SelectorListener> &el = it1->second;
         for (auto it2 = el.begin(); it2 != el.end(); ++it2)
         {
-            it2->second.Release();
+            it2->second.func.Release();
         }
     }
     m_events.clear();
+    m_selectors.clear();
+    m_matches.clear();
+    m_version++;
     counter = 0;
 }
 
+void EventPool::Dispatch(
+    DeviceDescriptor device, EventType type, NotificationHandler data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t key = combine_hashes(device, type);
+    auto found = m_events.find(key);
+    if (found == m_events.end())
+        return;
+
+    // device listeners are bound to their Device, they get no target.
+    data.target.kind = TARGET_NONE;
+    Clock::time_point now = Clock::now();
+    bool gated = false;
+    for (auto it = found->second.begin(); it != found->second.end(); ++it)
+    {
+        Listener &listener = it->second;
+        if (listener.gate.Push(now, data))
+            emit(listener.func, data);
+        gated = gated || listener.gate.Enabled();
+    }
+
+    if (gated)
+        m_cond.notify_one();
+}
+
+int EventPool::RegisterSelector(
+    Selector selector, EventType type, TSFN func, ListenerOptions options)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool gated = EventGate(options).Enabled();
+    SelectorListener listener {selector, func, options, gated, {}};
+    m_selectors[type][counter] = listener;
+    m_version++;
+
+    if (gated && !m_flusher.joinable())
+    {
+        m_flusher = std::thread(&EventPool::FlushLoop, this);
+    }
+    return counter++;
+}
+
+bool EventPool::RemoveSelector(EventType type, int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto bucket = m_selectors.find(type);
+    if (bucket == m_selectors.end())
+        return false;
+
+    auto found = bucket->second.find(id);
+    if (found == bucket->second.end())
+        return false;
+
+    found->second.func.Release();
+    bucket->second.erase(found);
+    m_version++;
+    return true;
+}
+
+void EventPool::DispatchSelectors(
+    const Subject &subject, EventType type, NotificationHandler data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto bucket = m_selectors.find(type);
+    if (bucket == m_selectors.end() || bucket->second.empty())
+        return;
+
+    uint64_t key = targetKey(subject.target);
+    size_t hash = std::hash<std::string>()(
+        subject.name + '\n' + subject.appName + '\n' + subject.device);
+    MatchCache &cache = m_matches[std::make_pair((int)type, key)];
+    if (cache.version != m_version || cache.subject != hash)
+    {
+        cache.version = m_version;
+        cache.subject = hash;
+        cache.ids.clear();
+        for (auto it = bucket->second.begin(); it != bucket->second.end();
+             ++it)
+        {
+            if (selectorMatches(it->second.selector, subject))
+                cache.ids.push_back(it->first);
+        }
+    }
+
+    data.target = subject.target;
+    Clock::time_point now = Clock::now();
+    bool gated = false;
+    for (int id : cache.ids)
+    {
+        SelectorListener &listener = bucket->second[id];
+        if (!listener.gated)
+        {
+            emit(listener.func, data);
+            continue;
+        }
+
+        auto gate = listener.gates.find(key);
+        if (gate == listener.gates.end())
+        {
+            EventGate fresh(listener.options);
+            gate = listener.gates.insert(std::make_pair(key, fresh)).first;
+        }
+        if (gate->second.Push(now, data))
+            emit(listener.func, data);
+        gated = true;
+    }
+
+    if (gated)
+        m_cond.notify_one();
+}
+
+void EventPool::ForgetTarget(Target target)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t key = targetKey(target);
+    for (auto it1 = m_selectors.begin(); it1 != m_selectors.end(); ++it1)
+    {
+        m_matches.erase(std::make_pair(it1->first, key));
+        for (auto it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
+        {
+            it2->second.gates.erase(key);
+        }
+    }
+}
+
+void EventPool::FlushLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        Clock::time_point now = Clock::now();
+        Clock::time_point next = Clock::time_point::max();
+        for (auto it1 = m_events.begin(); it1 != m_events.end(); ++it1)
+        {
+            for (auto it2 = it1->second.begin(); it2 != it1->second.end();
+                 ++it2)
+            {
+                Listener &listener = it2->second;
+                NotificationHandler data;
+                if (listener.gate.Flush(now, &data))
+                    emit(listener.func, data);
+
+                Clock::time_point deadline;
+                if (listener.gate.Deadline(&deadline) && deadline < next)
+                    next = deadline;
+            }
+        }
+
+        for (auto it1 = m_selectors.begin(); it1 != m_selectors.end(); ++it1)
+        {
+            for (auto it2 = it1->second.begin(); it2 != it1->second.end();
+                 ++it2)
+            {
+                SelectorListener &listener = it2->second;
+                for (auto it3 = listener.gates.begin();
+                     it3 != listener.gates.end(); ++it3)
+                {
+                    NotificationHandler data;
+                    if (it3->second.Flush(now, &data))
+                        emit(listener.func, data);
+
+                    Clock::time_point deadline;
+                    if (it3->second.Deadline(&deadline) && deadline < next)
+                        next = deadline;
+                }
+            }
+        }
+
+        if (next == Clock::time_point::max())
+            m_cond.wait(lock);
+        else
+            m_cond.wait_until(lock, next);
+    }
+}
+
 void CallJs(Napi::Env env, Napi::Function cb,
     Napi::Reference<Napi::Value> *owner, NotificationHandler *data)
 {
     if (env == nullptr || cb == nullptr)
     {
         if (data != nullptr)
-            delete data;
+            notificationPool.Release(data);
         return;
     }
 
@@ -149,13 +738,39 @@ void CallJs(Napi::Env env, Napi::Function cb,
         {
             value = Napi::Boolean::New(env, data->mute);
         }
+        else if (data->flags & DEVICE_CHANGE_MASK_PEAK)
+        {
+            value = Napi::Number::New(env, data->peak);
+        }
+        else if (data->flags & DEVICE_CHANGE_MASK_ACTIVE)
+        {
+            value = Napi::Boolean::New(env, data->active);
+        }
+        else if (data->flags & DEVICE_CHANGE_MASK_LOUDNESS)
+        {
+            PropertyKeys *keys = GetPropertyKeys(env);
+            Napi::Object reading = Napi::Object::New(env);
+            reading.Set(keys->momentary.Value(),
+                Napi::Number::New(env, data->momentary));
+            reading.Set(keys->shortTerm.Value(),
+                Napi::Number::New(env, data->shortTerm));
+            reading.Set(keys->integrated.Value(),
+                Napi::Number::New(env, data->integrated));
+            reading.Set(keys->samplePeak.Value(),
+                Napi::Number::New(env, data->peak));
+            value = reading;
+        }
         else /*if (data->flags & DEVICE_CHANGE_MASK_VOLUME) */
         {
             value = Napi::Number::New(env, data->volume);
         }
-        cb.Call(owner->Value(), {value});
+        if (data->target.kind != TARGET_NONE && targetResolver != NULL)
+            cb.Call(
+                owner->Value(), {value, targetResolver(env, data->target)});
+        else
+            cb.Call(owner->Value(), {value});
 
-        delete data;
+        notificationPool.Release(data);
     }
 }
 } // namespace SoundMixerUtils
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <napi.h>
+#include <regex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #define VALID_VOLUME_BALANCE(balance)             \
@@ -12,34 +19,109 @@
 #define DEVICE_CHANGE_MASK_MUTE 1
 #define DEVICE_CHANGE_MASK_VOLUME 2 * DEVICE_CHANGE_MASK_MUTE
 #define DEVICE_CHANGE_MASK_CHANNEL_COUNT 2 * DEVICE_CHANGE_MASK_VOLUME
+#define DEVICE_CHANGE_MASK_REMOVED 2 * DEVICE_CHANGE_MASK_CHANNEL_COUNT
+#define DEVICE_CHANGE_MASK_PEAK 2 * DEVICE_CHANGE_MASK_REMOVED
+#define DEVICE_CHANGE_MASK_LOUDNESS 2 * DEVICE_CHANGE_MASK_PEAK
+#define DEVICE_CHANGE_MASK_ACTIVE 2 * DEVICE_CHANGE_MASK_LOUDNESS
+
+#define NOTIFICATION_POOL_SIZE 256
 
 namespace SoundMixerUtils
 {
+enum DeviceType
+{
+    OUTPUT = 0,
+    INPUT = 1,
+    ALL = 2
+};
+
+enum TargetKind
+{
+    TARGET_NONE = 0,
+    TARGET_DEVICE = 1,
+    TARGET_SESSION = 2
+};
+
+/**
+ *  \brief     Identifies the device or session a notification is about.
+ */
+typedef struct
+{
+    TargetKind kind;
+    DeviceType type;
+    uint32_t index;
+} Target;
+
 typedef struct
 {
     int flags;
     float volume;
     bool mute;
+    Target target;
+    // signal level in [0, 1] of DEVICE_CHANGE_MASK_PEAK notifications, and
+    // the sample peak of DEVICE_CHANGE_MASK_LOUDNESS ones
+    float peak;
+    // LUFS of DEVICE_CHANGE_MASK_LOUDNESS notifications
+    float momentary;
+    float shortTerm;
+    float integrated;
+    // whether a session plays, of DEVICE_CHANGE_MASK_ACTIVE notifications
+    bool active;
 } NotificationHandler;
 
+typedef struct
+{
+    uint64_t hits;
+    uint64_t misses;
+} NotificationPoolStats;
+
+/**
+ *  \brief     Fixed-size, lock-free free list of NotificationHandler slots.
+ *
+ *  \remarks   Producers acquire a slot before handing it to a TSFN and
+ *  CallJs releases it once dispatched. When the pool is exhausted, Acquire
+ *  falls back to the heap and Release frees such payloads with delete.
+ */
+class NotificationPool {
+  public:
+    NotificationPool();
+
+    NotificationHandler *Acquire();
+    void Release(NotificationHandler *data);
+    NotificationPoolStats Stats();
+
+  private:
+    NotificationHandler slots[NOTIFICATION_POOL_SIZE];
+    std::atomic<uint32_t> next[NOTIFICATION_POOL_SIZE];
+    // tagged head of the free list: (aba tag << 32) | slot index
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+};
+
+extern NotificationPool notificationPool;
+
 void CallJs(Napi::Env env, Napi::Function cb,
     Napi::Reference<Napi::Value> *context, NotificationHandler *data);
 
 using TSFN = Napi::TypedThreadSafeFunction<Napi::Reference<Napi::Value>,
     NotificationHandler, CallJs>;
 
-enum DeviceType
-{
-    OUTPUT = 0,
-    INPUT = 1,
-    ALL = 2
-};
+/**
+ *  \brief     Builds the JS object a selector listener receives as second
+ *  argument, set by the platform bindings.
+ */
+typedef Napi::Value (*target_resolver_t)(Napi::Env, Target);
+extern target_resolver_t targetResolver;
 
 enum EventType
 {
     VOLUME = 0,
     MUTE = 1,
-    COUNT = 2
+    PEAK = 2,
+    LOUDNESS = 3,
+    ACTIVE = 4,
+    COUNT = 5
 };
 
 typedef struct
@@ -59,19 +141,224 @@ typedef struct
     bool stereo;
 } VolumeBalance;
 
+/**
+ *  \brief     Property keys of the plain objects built by the bindings,
+ *  created once and kept in the instance data of the environment.
+ */
+typedef struct
+{
+    Napi::Reference<Napi::String> right;
+    Napi::Reference<Napi::String> left;
+    Napi::Reference<Napi::String> stereo;
+    Napi::Reference<Napi::String> positions;
+    Napi::Reference<Napi::String> volumes;
+    Napi::Reference<Napi::String> momentary;
+    Napi::Reference<Napi::String> shortTerm;
+    Napi::Reference<Napi::String> integrated;
+    Napi::Reference<Napi::String> samplePeak;
+    Napi::Reference<Napi::String> hits;
+    Napi::Reference<Napi::String> misses;
+} PropertyKeys;
+
+PropertyKeys *InitPropertyKeys(Napi::Env env);
+PropertyKeys *GetPropertyKeys(Napi::Env env);
+
+/**
+ *  \brief      Exposes the dispose() method of a class under Symbol.dispose
+ *  as well, on runtimes that define it.
+ */
+void AliasDisposeSymbol(Napi::Function cls);
+
+typedef struct
+{
+    // calls per second and milliseconds, 0 when unset
+    double maxRate;
+    double debounceMs;
+    bool leading;
+    bool trailing;
+} ListenerOptions;
+
+/**
+ *  \brief     Parses the `{ maxRate, debounceMs, leading, trailing }` object
+ *  given to `Device.on()`.
+ *
+ *  \returns   false if a JS exception has been thrown.
+ */
+bool ParseListenerOptions(
+    Napi::Env env, Napi::Value value, ListenerOptions *options);
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ *  \brief     Rate limiting and debouncing state of one listener.
+ *
+ *  \remarks   Debouncing delays delivery until no event happened for
+ *  `debounceMs`, rate limiting caps deliveries to `maxRate` per second. When
+ *  both are set, `maxRate` bounds how long a debounced payload may wait.
+ */
+class EventGate {
+  public:
+    EventGate();
+    EventGate(ListenerOptions options);
+
+    bool Enabled();
+
+    /**
+     *  \returns   true if the payload must be delivered right away.
+     */
+    bool Push(Clock::time_point now, const NotificationHandler &data);
+
+    /**
+     *  \returns   true if a delayed payload is due, it is then stored in out.
+     */
+    bool Flush(Clock::time_point now, NotificationHandler *out);
+    bool Deadline(Clock::time_point *out);
+
+  private:
+    Clock::duration wait {0};
+    Clock::duration maxWait {0};
+    bool hasMaxWait;
+    bool leading;
+    bool trailing;
+
+    bool active = false;
+    bool pending = false;
+    bool invoked = false;
+    NotificationHandler last;
+    Clock::time_point lastEvent;
+    Clock::time_point lastInvoke;
+};
+
+/**
+ *  \brief     The properties a Selector is evaluated against.
+ */
+typedef struct
+{
+    Target target;
+    std::string name;
+    std::string appName;
+    std::string device;
+} Subject;
+
+/**
+ *  \brief     Matches a property either exactly or against a JS RegExp,
+ *  evaluated with the ECMAScript grammar of std::regex.
+ */
+class Matcher {
+  public:
+    Matcher();
+    Matcher(const std::string &value);
+    Matcher(const std::string &pattern, bool icase);
+
+    bool Match(const std::string &value) const;
+
+  private:
+    bool any;
+    std::string value;
+    std::shared_ptr<std::regex> regex;
+};
+
+/**
+ *  \brief     Reads the matcher of param[key], left untouched when the key
+ *  is undefined.
+ *
+ *  \returns   false if a JS exception has been thrown.
+ */
+bool ParseMatcher(
+    Napi::Env env, Napi::Object param, const char *key, Matcher *out);
+
+typedef struct
+{
+    // TARGET_NONE matches devices and sessions
+    TargetKind kind;
+    // -1 matches both types
+    int type;
+    Matcher name;
+    Matcher appName;
+    Matcher device;
+} Selector;
+
+/**
+ *  \brief     Parses the `{ type, deviceType, name, appName, device }` object
+ *  given to `SoundMixer.on()`.
+ *
+ *  \returns   false if a JS exception has been thrown.
+ */
+bool ParseSelector(Napi::Env env, Napi::Value value, Selector *selector);
+bool selectorMatches(const Selector &selector, const Subject &subject);
+
 class EventPool {
   public:
     EventPool();
     virtual ~EventPool();
 
-    int RegisterEvent(DeviceDescriptor device, EventType type, TSFN value);
+    int RegisterEvent(DeviceDescriptor device, EventType type, TSFN value,
+        ListenerOptions options = ListenerOptions());
     bool RemoveEvent(DeviceDescriptor device, EventType type, int id);
     std::vector<TSFN> GetListeners(DeviceDescriptor dev, EventType type);
     void RemoveAllListeners(DeviceDescriptor device, EventType type);
     void Clear();
 
+    /**
+     *  \brief     Delivers data to the listeners of the given event, holding
+     *  back the payloads their rate limit or debounce settings drop.
+     */
+    void Dispatch(
+        DeviceDescriptor device, EventType type, NotificationHandler data);
+
+    /**
+     *  \brief     Registers a listener on every present and future object
+     *  matching the selector.
+     */
+    int RegisterSelector(Selector selector, EventType type, TSFN value,
+        ListenerOptions options = ListenerOptions());
+    bool RemoveSelector(EventType type, int id);
+    void DispatchSelectors(
+        const Subject &subject, EventType type, NotificationHandler data);
+
+    /**
+     *  \brief     Drops the state kept for an object that has been removed.
+     */
+    void ForgetTarget(Target target);
+
   private:
-    std::map<uint32_t, std::map<int, TSFN>> m_events;
+    struct Listener
+    {
+        TSFN func;
+        EventGate gate;
+    };
+
+    struct SelectorListener
+    {
+        Selector selector;
+        TSFN func;
+        ListenerOptions options;
+        bool gated;
+        // one gate per matched object
+        std::map<uint64_t, EventGate> gates;
+    };
+
+    struct MatchCache
+    {
+        uint32_t version;
+        size_t subject;
+        std::vector<int> ids;
+    };
+
+    void FlushLoop();
+
+    std::map<uint32_t, std::map<int, Listener>> m_events;
     int counter = 0;
+
+    // selector index: listeners by event type, and the ids matching each
+    // object, recomputed when the selectors or the object properties change.
+    std::map<int, std::map<int, SelectorListener>> m_selectors;
+    std::map<std::pair<int, uint64_t>, MatchCache> m_matches;
+    uint32_t m_version = 1;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_flusher;
+    bool m_stopping = false;
 };
 } // namespace SoundMixerUtils
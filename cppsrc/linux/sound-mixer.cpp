@@ -1,29 +1,206 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include "sound-mixer.hpp"
 #include "linux-sound-mixer.hpp"
 
 using namespace LinuxSoundMixer;
+using namespace SoundMixerUtils;
+using std::vector;
+
+#define METER_RATE_DEFAULT 25
+#define METER_RATE_MAX 1000
+#define METER_RING_SLOTS 256
+#define LOUDNESS_INTERVAL_DEFAULT 100
+#define LOUDNESS_INTERVAL_MIN 10
+#define LOUDNESS_INTERVAL_MAX 60000
+// -60 dBFS
+#define SILENCE_THRESHOLD_DEFAULT 0.001F
+#define SILENCE_HOLD_DEFAULT 1000
+#define SILENCE_HOLD_MIN 100
+#define SILENCE_HOLD_MAX 600000
+
+#define DUCK_DEPTH_DEFAULT 12.
+#define DUCK_DEPTH_MAX 60.
+#define DUCK_ATTACK_DEFAULT 50
+#define DUCK_RELEASE_DEFAULT 500
+#define DUCK_TIME_MAX 60000
+// fragments waiting for the JS thread before new ones are dropped
+#define CAPTURE_QUEUE_SIZE 64
+#define SPECTRUM_RATE 48000
+#define SPECTRUM_RING_SLOTS 16
+#define SPECTRUM_SIZE_MIN 64
+#define SPECTRUM_SIZE_MAX 16384
+#define SPECTRUM_BANDS_MAX 256
 
 namespace SoundMixer
 {
 Napi::FunctionReference *DeviceObject::constructor;
 Napi::FunctionReference *AudioSessionObject::constructor;
+Napi::FunctionReference *CaptureObject::constructor;
+Napi::FunctionReference *VolumeGroupObject::constructor;
+SoundMixerUtils::EventPool *MixerObject::eventPool;
+
+LinuxSoundMixer::SoundMixer *MixerObject::mixer;
+WrapperCache *MixerObject::wrappers;
+
+static uint64_t _target_id(Target target)
+{
+    return ((uint64_t)target.kind << 40) | ((uint64_t)target.type << 32)
+        | target.index;
+}
+
+WrapperCache::Key WrapperCache::KeyOf(Target target)
+{
+    uint64_t id = _target_id(target);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_generations.find(id);
+
+    return Key(id, it == m_generations.end() ? 0 : it->second);
+}
+
+Napi::Object WrapperCache::Find(const Key &key)
+{
+    auto it = m_wrappers.find(key);
+    if (it == m_wrappers.end())
+        return Napi::Object();
+
+    // empty once the wrapper has been collected
+    return it->second.ref.Value();
+}
+
+void WrapperCache::Insert(const Key &key, Napi::Object wrapper, void *owner)
+{
+    Entry &entry = m_wrappers[key];
+    entry.ref = Napi::Weak(wrapper);
+    entry.owner = owner;
+}
+
+void WrapperCache::Erase(const Key &key, void *owner)
+{
+    auto it = m_wrappers.find(key);
+    // the slot may already hold a newer wrapper if this one was collected
+    // before its finalizer ran
+    if (it != m_wrappers.end() && it->second.owner == owner)
+        m_wrappers.erase(it);
+}
+
+void WrapperCache::Invalidate(Target target)
+{
+    uint64_t id = _target_id(target);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_generations[id]++;
+}
+
+void MixerObject::on_device_change_cb(
+    DeviceDescriptor desc, NotificationHandler data)
+{
+    if (data.flags & DEVICE_CHANGE_MASK_REMOVED)
+    {
+        wrappers->Invalidate(data.target);
+        eventPool->ForgetTarget(data.target);
+        return;
+    }
+
+    Subject subject {data.target, desc.id, "", desc.id};
+    if (data.flags & DEVICE_CHANGE_MASK_MUTE)
+    {
+        NotificationHandler payload = data;
+        payload.flags = DEVICE_CHANGE_MASK_MUTE;
+        eventPool->Dispatch(desc, EventType::MUTE, payload);
+        eventPool->DispatchSelectors(subject, EventType::MUTE, payload);
+    }
+
+    if (data.flags & DEVICE_CHANGE_MASK_VOLUME)
+    {
+        NotificationHandler payload = data;
+        payload.flags = DEVICE_CHANGE_MASK_VOLUME;
+        eventPool->Dispatch(desc, EventType::VOLUME, payload);
+        eventPool->DispatchSelectors(subject, EventType::VOLUME, payload);
+    }
+
+    if (data.flags & DEVICE_CHANGE_MASK_PEAK)
+    {
+        eventPool->Dispatch(desc, EventType::PEAK, data);
+        eventPool->DispatchSelectors(subject, EventType::PEAK, data);
+    }
+
+    if (data.flags & DEVICE_CHANGE_MASK_LOUDNESS)
+    {
+        eventPool->Dispatch(desc, EventType::LOUDNESS, data);
+        eventPool->DispatchSelectors(subject, EventType::LOUDNESS, data);
+    }
+}
+
+void MixerObject::on_session_change_cb(
+    Subject subject, NotificationHandler data)
+{
+    if (data.flags & DEVICE_CHANGE_MASK_REMOVED)
+    {
+        wrappers->Invalidate(data.target);
+        eventPool->ForgetTarget(data.target);
+        return;
+    }
+
+    if (data.flags & DEVICE_CHANGE_MASK_MUTE)
+    {
+        NotificationHandler payload = data;
+        payload.flags = DEVICE_CHANGE_MASK_MUTE;
+        eventPool->DispatchSelectors(subject, EventType::MUTE, payload);
+    }
+
+    if (data.flags & DEVICE_CHANGE_MASK_VOLUME)
+    {
+        NotificationHandler payload = data;
+        payload.flags = DEVICE_CHANGE_MASK_VOLUME;
+        eventPool->DispatchSelectors(subject, EventType::VOLUME, payload);
+    }
 
-LinuxSoundMixer::SoundMixer *mixer = new LinuxSoundMixer::SoundMixer();
+    if (data.flags & DEVICE_CHANGE_MASK_PEAK)
+        eventPool->DispatchSelectors(subject, EventType::PEAK, data);
+
+    if (data.flags & DEVICE_CHANGE_MASK_LOUDNESS)
+        eventPool->DispatchSelectors(subject, EventType::LOUDNESS, data);
+
+    if (data.flags & DEVICE_CHANGE_MASK_ACTIVE)
+        eventPool->DispatchSelectors(subject, EventType::ACTIVE, data);
+}
 
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
+    InitPropertyKeys(env);
     MixerObject::Init(env, exports);
     DeviceObject::Init(env, exports);
     AudioSessionObject::Init(env, exports);
+    CaptureObject::Init(env, exports);
+    VolumeGroupObject::Init(env, exports);
 
     return exports;
 }
 
 Napi::Object MixerObject::Init(Napi::Env env, Napi::Object exports)
 {
+    eventPool = new SoundMixerUtils::EventPool();
+    wrappers = new WrapperCache();
+    mixer = new LinuxSoundMixer::SoundMixer(
+        MixerObject::on_device_change_cb, MixerObject::on_session_change_cb);
+    targetResolver = MixerObject::ResolveTarget;
     Napi::Function sm = DefineClass(env, "SoundMixer",
         {StaticAccessor<&MixerObject::GetDevices>("devices"),
-            StaticMethod<&MixerObject::GetDefaultDevice>("getDefaultDevice")});
+            StaticAccessor<&MixerObject::GetPoolStats>("poolStats"),
+            StaticMethod<&MixerObject::GetDefaultDevice>("getDefaultDevice"),
+            StaticMethod<&MixerObject::SetDefaultDevice>("setDefaultDevice"),
+            StaticAccessor<&MixerObject::GetVolumeScale,
+                &MixerObject::SetVolumeScale>("volumeScale"),
+            StaticMethod<&MixerObject::SetRules>("setRules"),
+            StaticMethod<&MixerObject::CreateGroup>("createGroup"),
+            StaticMethod<&MixerObject::MoveSessions>("moveSessions"),
+            StaticMethod<&MixerObject::UploadSample>("uploadSample"),
+            StaticMethod<&MixerObject::RemoveSample>("removeSample"),
+            StaticMethod<&MixerObject::StartDucking>("duck"),
+            StaticMethod<&MixerObject::StopDucking>("stopDucking"),
+            StaticMethod<&MixerObject::RegisterEvent>("on"),
+            StaticMethod<&MixerObject::RemoveEvent>("removeListener")});
 
     exports.Set("SoundMixer", sm);
 
@@ -40,6 +217,8 @@ MixerObject::~MixerObject()
     delete mixer;
     delete AudioSessionObject::constructor;
     delete DeviceObject::constructor;
+    delete CaptureObject::constructor;
+    delete VolumeGroupObject::constructor;
 }
 
 Napi::Value MixerObject::GetDefaultDevice(const Napi::CallbackInfo &info)
@@ -61,211 +240,2379 @@ Napi::Value MixerObject::GetDevices(const Napi::CallbackInfo &info)
     return result;
 }
 
-Napi::Object DeviceObject::Init(Napi::Env env, Napi::Object exports)
+Napi::Value MixerObject::GetPoolStats(const Napi::CallbackInfo &info)
 {
+    NotificationPoolStats stats = notificationPool.Stats();
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
+    Napi::Object result = Napi::Object::New(info.Env());
+    result.Set(keys->hits.Value(),
+        Napi::Number::New(info.Env(), (double)stats.hits));
+    result.Set(keys->misses.Value(),
+        Napi::Number::New(info.Env(), (double)stats.misses));
+    return result;
+}
 
-    constructor = new Napi::FunctionReference();
-    *constructor = Napi::Persistent(GetClass(env));
+Napi::Value MixerObject::GetVolumeScale(const Napi::CallbackInfo &info)
+{
+    switch (LinuxSoundMixer::GetVolumeScale())
+    {
+        case VolumeScale::CUBIC:
+            return Napi::String::New(info.Env(), "cubic");
+        case VolumeScale::DECIBEL:
+            return Napi::String::New(info.Env(), "dB");
+        default:
+            return Napi::String::New(info.Env(), "linear");
+    }
+}
 
-    return exports;
+void MixerObject::SetVolumeScale(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    std::string name;
+    if (value.IsString())
+        name = value.As<Napi::String>();
+    if (name == "linear")
+        LinuxSoundMixer::SetVolumeScale(VolumeScale::LINEAR);
+    else if (name == "cubic")
+        LinuxSoundMixer::SetVolumeScale(VolumeScale::CUBIC);
+    else if (name == "dB")
+        LinuxSoundMixer::SetVolumeScale(VolumeScale::DECIBEL);
+    else
+        Napi::Error::New(info.Env(), "Expected 'linear', 'cubic' or 'dB'")
+            .ThrowAsJavaScriptException();
 }
 
-Napi::Function DeviceObject::GetClass(Napi::Env env)
+/**
+ *  \brief      Reads an optional volume of a rule, in the current scale.
+ */
+static bool parseRuleVolume(
+    Napi::Env env, Napi::Object param, const char *key, pa_volume_t *out)
 {
-    Napi::Function func = DefineClass(env, "Device",
-        {InstanceAccessor<&DeviceObject::GetVolume, &DeviceObject::SetVolume>(
-             "volume"),
-            InstanceAccessor<&DeviceObject::GetMute, &DeviceObject::SetMute>(
-                "mute"),
-            InstanceAccessor<&DeviceObject::GetChannelVolume,
-                &DeviceObject::SetChannelVolume>("balance"),
-            InstanceAccessor<&DeviceObject::GetSessions>("sessions")});
+    *out = PA_VOLUME_INVALID;
+    Napi::Value v = param.Get(key);
+    if (v.IsUndefined())
+        return true;
+    if (!v.IsNumber() || !ValidScalar(v.As<Napi::Number>().FloatValue()))
+    {
+        Napi::Error::New(env,
+            std::string("Expected <") + key + "> to be a valid volume")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
 
-    return func;
+    *out = VolumeFromScalar(v.As<Napi::Number>().FloatValue());
+    return true;
 }
 
-DeviceObject::DeviceObject(const Napi::CallbackInfo &info)
-    : Napi::ObjectWrap<DeviceObject>(info)
+/**
+ *  \brief      Parses a `{ match, volume, mute, maxVolume }` object given
+ *  to `SoundMixer.setRules()`.
+ */
+static bool parseRule(Napi::Env env, Napi::Value value, SessionRule *rule)
 {
+    *rule = SessionRule {-1, Matcher(), Matcher(), Matcher(),
+        PA_VOLUME_INVALID, PA_VOLUME_INVALID, -1};
+    if (!value.IsObject())
+    {
+        Napi::Error::New(env, "Expected every rule to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object param = value.As<Napi::Object>();
+    Napi::Value match = param.Get("match");
+    if (!match.IsUndefined())
+    {
+        if (!match.IsObject())
+        {
+            Napi::Error::New(env, "Expected <match> to be an object")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        Napi::Object m = match.As<Napi::Object>();
+        Napi::Value type = m.Get("deviceType");
+        if (type.IsNumber())
+            rule->type = type.As<Napi::Number>().Int32Value();
+        if (!ParseMatcher(env, m, "appName", &rule->appName)
+            || !ParseMatcher(env, m, "binary", &rule->binary)
+            || !ParseMatcher(env, m, "role", &rule->role))
+            return false;
+    }
+
+    Napi::Value mute = param.Get("mute");
+    if (!mute.IsUndefined() && !mute.IsBoolean())
+    {
+        Napi::Error::New(env, "Expected <mute> to be a boolean")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    if (mute.IsBoolean())
+        rule->mute = mute.As<Napi::Boolean>().Value() ? 1 : 0;
+
+    return parseRuleVolume(env, param, "volume", &rule->volume)
+        && parseRuleVolume(env, param, "maxVolume", &rule->maxVolume);
 }
 
-DeviceObject::~DeviceObject()
+Napi::Value MixerObject::SetRules(const Napi::CallbackInfo &info)
 {
-    delete reinterpret_cast<_Device *>(pDevice);
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsArray())
+    {
+        Napi::Error::New(env, "Expected <rules> to be an array")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    // volumes are converted now, with the scale of the caller
+    Napi::Array values = info[0].As<Napi::Array>();
+    vector<SessionRule> rules(values.Length());
+    for (uint32_t i = 0; i < values.Length(); i++)
+    {
+        if (!parseRule(env, values.Get(i), &rules[i]))
+            return Napi::Boolean::New(env, false);
+    }
+
+    return Napi::Boolean::New(env, mixer->SetRules(rules));
 }
 
-Napi::Value DeviceObject::New(Napi::Env env, void *device)
+/**
+ *  \brief      Parses the `{ depth, attackMs, releaseMs }` object given to
+ *  `SoundMixer.duck()`.
+ */
+static bool parseDuckOptions(Napi::Env env, Napi::Value value, double *depth,
+    uint32_t *attackMs, uint32_t *releaseMs)
 {
+    *depth = DUCK_DEPTH_DEFAULT;
+    *attackMs = DUCK_ATTACK_DEFAULT;
+    *releaseMs = DUCK_RELEASE_DEFAULT;
+    if (value.IsUndefined() || value.IsNull())
+        return true;
 
-    _Device *dev = reinterpret_cast<_Device *>(device);
-    Napi::Object result = constructor->New({});
-    Napi::ObjectWrap<DeviceObject>::Unwrap(result)->pDevice = dev;
-    result.Set("name", dev->friendlyName());
-    result.Set("type", (int)dev->type());
+    if (!value.IsObject())
+    {
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
 
-    return result;
+    Napi::Object param = value.As<Napi::Object>();
+    Napi::Value d = param.Get("depth");
+    Napi::Value a = param.Get("attackMs");
+    Napi::Value r = param.Get("releaseMs");
+    bool valid = (d.IsUndefined() || d.IsNumber())
+        && (a.IsUndefined() || a.IsNumber())
+        && (r.IsUndefined() || r.IsNumber());
+    if (valid && d.IsNumber())
+    {
+        *depth = d.As<Napi::Number>().DoubleValue();
+        valid = *depth > 0. && *depth <= DUCK_DEPTH_MAX;
+    }
+    Napi::Value times[] = {a, r};
+    uint32_t *outs[] = {attackMs, releaseMs};
+    for (int i = 0; i < 2 && valid; i++)
+    {
+        if (!times[i].IsNumber())
+            continue;
+        double ms = times[i].As<Napi::Number>().DoubleValue();
+        valid = ms >= 0 && ms <= DUCK_TIME_MAX;
+        *outs[i] = (uint32_t)ms;
+    }
+    if (!valid)
+    {
+        Napi::Error::New(env,
+            "Expected { depth: dB in ]0, "
+                + std::to_string((int)DUCK_DEPTH_MAX)
+                + "], attackMs and releaseMs: numbers between 0 and "
+                + std::to_string(DUCK_TIME_MAX) + " }")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return true;
 }
 
-Napi::Value DeviceObject::GetVolume(const Napi::CallbackInfo &info)
+Napi::Value MixerObject::StartDucking(const Napi::CallbackInfo &info)
 {
-    _Device *dev = reinterpret_cast<_Device *>(pDevice);
-    return Napi::Number::New(info.Env(), dev->GetVolume());
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || info.Length() > 3)
+    {
+        Napi::Error::New(env, "Expected <trigger> <target> [options]")
+            .ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+
+    Selector trigger, target;
+    double depth;
+    uint32_t attackMs, releaseMs;
+    if (!ParseSelector(env, info[0], &trigger)
+        || !ParseSelector(env, info[1], &target)
+        || !parseDuckOptions(env, info[2], &depth, &attackMs, &releaseMs))
+        return Napi::Number::New(env, -1);
+
+    // only sessions are ducked
+    trigger.kind = TARGET_SESSION;
+    target.kind = TARGET_SESSION;
+    return Napi::Number::New(env,
+        mixer->StartDucking(trigger, target, depth, attackMs, releaseMs));
 }
 
-void DeviceObject::SetVolume(
-    const Napi::CallbackInfo &info, const Napi::Value &value)
+Napi::Value MixerObject::StopDucking(const Napi::CallbackInfo &info)
 {
-    float volume = value.As<Napi::Number>().FloatValue();
-    _Device *dev = reinterpret_cast<_Device *>(pDevice);
-    dev->SetVolume(volume);
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsNumber())
+    {
+        Napi::Error::New(env, "Expected <handler>")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    return Napi::Boolean::New(
+        env, mixer->StopDucking(info[0].As<Napi::Number>().Int32Value()));
 }
 
-Napi::Value DeviceObject::GetMute(const Napi::CallbackInfo &info)
+/**
+ *  \brief      Reads the Device and AudioSession objects given to
+ *  `SoundMixer.createGroup()`.
+ */
+static bool parseMembers(Napi::Env env, Napi::Value value, vector<Target> *out)
 {
-    _Device *dev = reinterpret_cast<_Device *>(pDevice);
-    return Napi::Boolean::New(info.Env(), dev->GetMute());
+    if (!value.IsArray())
+    {
+        Napi::Error::New(env, "Expected <members> to be an array")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Array members = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < members.Length(); i++)
+    {
+        Napi::Value member = members.Get(i);
+        Target target;
+        bool valid = false;
+        if (member.IsObject())
+        {
+            Napi::Object obj = member.As<Napi::Object>();
+            if (obj.InstanceOf(DeviceObject::constructor->Value()))
+                valid = DeviceObject::Unwrap(obj)->GetTarget(&target);
+            else if (obj.InstanceOf(AudioSessionObject::constructor->Value()))
+                valid = AudioSessionObject::Unwrap(obj)->GetTarget(&target);
+        }
+        if (!valid)
+        {
+            Napi::Error::New(env,
+                "Expected every member to be a Device or an AudioSession "
+                "that has not been disposed")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        out->push_back(target);
+    }
+
+    return true;
 }
 
-void DeviceObject::SetMute(
-    const Napi::CallbackInfo &info, const Napi::Value &value)
+/**
+ *  \brief      Reads the Device sessions are moved to.
+ */
+static bool parseDestination(Napi::Env env, Napi::Value value, Target *out)
 {
-    bool val = value.As<Napi::Boolean>().Value();
-    _Device *dev = reinterpret_cast<_Device *>(pDevice);
-    dev->SetMute(val);
+    if (value.IsObject()
+        && value.As<Napi::Object>().InstanceOf(
+            DeviceObject::constructor->Value())
+        && DeviceObject::Unwrap(value.As<Napi::Object>())->GetTarget(out))
+        return true;
+
+    Napi::Error::New(env, "Expected <device> to be a Device")
+        .ThrowAsJavaScriptException();
+    return false;
 }
 
-Napi::Value DeviceObject::GetChannelVolume(const Napi::CallbackInfo &info)
+Napi::Value MixerObject::MoveSessions(const Napi::CallbackInfo &info)
 {
-    _Device *dev = reinterpret_cast<_Device *>(pDevice);
-    VolumeBalance balance = dev->GetVolumeBalance();
-    Napi::Object result = Napi::Object::New(info.Env());
-    result.Set("right", balance.right);
-    result.Set("left", balance.left);
-    result.Set("stereo", balance.stereo);
-    return result;
+    Napi::Env env = info.Env();
+    Selector selector;
+    Target device;
+    if (!ParseSelector(env, info[0], &selector)
+        || !parseDestination(env, info[1], &device))
+        return Napi::Number::New(env, 0);
+
+    // streams only move between devices of their own type
+    selector.kind = TARGET_SESSION;
+    selector.type = (int)device.type;
+    vector<Target> sessions = mixer->FindSessions(selector);
+    return Napi::Number::New(
+        env, (double)mixer->MoveSessions(sessions, device.index));
 }
 
-void DeviceObject::SetChannelVolume(
-    const Napi::CallbackInfo &info, const Napi::Value &value)
+Napi::Value MixerObject::SetDefaultDevice(const Napi::CallbackInfo &info)
 {
-    Napi::Object param = value.As<Napi::Object>();
-    if (!param.Has("right") || !param.Has("left"))
+    Napi::Env env = info.Env();
+    Target target;
+    if (!parseDestination(env, info[0], &target))
+        return Napi::Boolean::New(env, false);
+
+    bool moveSessions = false;
+    if (info[1].IsObject())
     {
-        return;
+        Napi::Value v = info[1].As<Napi::Object>().Get("moveSessions");
+        moveSessions = v.ToBoolean().Value();
+    }
+    else if (!info[1].IsUndefined())
+    {
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
     }
-    _Device *dev = reinterpret_cast<_Device *>(pDevice);
-    VolumeBalance balance
-        = {param.Get("right").As<Napi::Number>().FloatValue(),
-            param.Get("left").As<Napi::Number>().FloatValue(), true};
 
-    dev->SetVolumeBalance(balance);
+    _Device *device = mixer->GetDeviceByIndex(target.index, target.type);
+    if (device == nullptr)
+        return Napi::Boolean::New(env, false);
+    bool done = mixer->SetDefaultDevice(device, moveSessions);
+    delete device;
+
+    return Napi::Boolean::New(env, done);
 }
 
-Napi::Value DeviceObject::GetSessions(const Napi::CallbackInfo &info)
+Napi::Value MixerObject::CreateGroup(const Napi::CallbackInfo &info)
 {
-    _Device *dev = reinterpret_cast<_Device *>(pDevice);
-    Napi::Array result = Napi::Array::New(info.Env());
-    int i = 0;
-    for (_AudioSession *s : dev->GetAudioSessions())
+    Napi::Env env = info.Env();
+    vector<Target> members;
+    if (!parseMembers(env, info[0], &members))
+        return env.Null();
+
+    bool relative = false;
+    Napi::Value options = info[1];
+    if (options.IsObject())
     {
-        result.Set(i++, AudioSessionObject::New(info.Env(), s));
+        Napi::Value mode = options.As<Napi::Object>().Get("mode");
+        std::string name = mode.IsString()
+            ? mode.As<Napi::String>().Utf8Value()
+            : (mode.IsUndefined() ? "absolute" : "");
+        if (name != "absolute" && name != "relative")
+        {
+            Napi::Error::New(env, "Expected <mode> to be 'absolute' or "
+                                  "'relative'")
+                .ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        relative = name == "relative";
+    }
+    else if (!options.IsUndefined())
+    {
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    return result;
+    return VolumeGroupObject::New(env, members, relative);
 }
 
-AudioSessionObject::AudioSessionObject(const Napi::CallbackInfo &info)
-    : Napi::ObjectWrap<AudioSessionObject>(info)
+static Napi::Value channelsToObject(
+    Napi::Env env, const ChannelVolumes &values)
 {
+    PropertyKeys *keys = GetPropertyKeys(env);
+    Napi::Uint8Array positions = Napi::Uint8Array::New(env, values.channels);
+    Napi::Float32Array volumes = Napi::Float32Array::New(env, values.channels);
+    std::memcpy(positions.Data(), values.positions, values.channels);
+    std::memcpy(
+        volumes.Data(), values.volumes, values.channels * sizeof(float));
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(keys->positions.Value(), positions);
+    result.Set(keys->volumes.Value(), volumes);
+    return result;
 }
 
-Napi::Function AudioSessionObject::GetClass(Napi::Env env)
+static bool isTypedArrayOf(Napi::Value value, napi_typedarray_type type)
 {
-    return DefineClass(env, "AudioSession",
-        {InstanceAccessor<&AudioSessionObject::GetMute,
-             &AudioSessionObject::SetMute>("mute"),
-            InstanceAccessor<&AudioSessionObject::GetVolume,
-                &AudioSessionObject::SetVolume>("volume"),
-            InstanceAccessor<&AudioSessionObject::GetChannelVolume,
-                &AudioSessionObject::SetChannelVolume>("balance")});
+    return value.IsTypedArray()
+        && value.As<Napi::TypedArray>().TypedArrayType() == type;
 }
 
-Napi::Object AudioSessionObject::Init(Napi::Env env, Napi::Object exports)
+/**
+ *  \brief      Reads either a Float32Array of volumes in channel order, or
+ *  a { positions: Uint8Array, volumes: Float32Array } object.
+ */
+static bool parseChannels(
+    Napi::Env env, Napi::Value value, ChannelVolumes *out)
 {
-    constructor = new Napi::FunctionReference();
-    *constructor = Napi::Persistent(GetClass(env));
+    Napi::Value volumes = value;
+    Napi::Value positions = env.Undefined();
+    if (value.IsObject() && !value.IsTypedArray())
+    {
+        PropertyKeys *keys = GetPropertyKeys(env);
+        Napi::Object param = value.As<Napi::Object>();
+        volumes = param.Get(keys->volumes.Value());
+        positions = param.Get(keys->positions.Value());
+    }
 
-    return exports;
+    if (!isTypedArrayOf(volumes, napi_float32_array)
+        || (!positions.IsUndefined()
+            && !isTypedArrayOf(positions, napi_uint8_array)))
+    {
+        Napi::Error::New(env,
+            "Expected a Float32Array or "
+            "{ positions: Uint8Array, volumes: Float32Array }")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Float32Array v = volumes.As<Napi::Float32Array>();
+    size_t count = std::min(v.ElementLength(), (size_t)PA_CHANNELS_MAX);
+    out->channels = (uint8_t)count;
+    out->mapped = !positions.IsUndefined();
+    std::memcpy(out->volumes, v.Data(), count * sizeof(float));
+    if (out->mapped)
+    {
+        Napi::Uint8Array p = positions.As<Napi::Uint8Array>();
+        if (p.ElementLength() != v.ElementLength())
+        {
+            Napi::Error::New(env, "positions and volumes differ in length")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        std::memcpy(out->positions, p.Data(), count);
+    }
+
+    return true;
 }
 
-AudioSessionObject::~AudioSessionObject()
+static bool parseEventType(std::string eventName, EventType *eventType)
 {
-    delete reinterpret_cast<_AudioSession *>(pSession);
+    if (eventName == "volume")
+        *eventType = EventType::VOLUME;
+    else if (eventName == "mute")
+        *eventType = EventType::MUTE;
+    else if (eventName == "peak")
+        *eventType = EventType::PEAK;
+    else if (eventName == "loudness")
+        *eventType = EventType::LOUDNESS;
+    else if (eventName == "activeChanged")
+        *eventType = EventType::ACTIVE;
+    else
+        return false;
+    return true;
 }
 
-Napi::Value AudioSessionObject::New(Napi::Env env, void *data)
+/**
+ *  \brief      Parses the `{ rateHz }` object given to `startMeter()`.
+ */
+static bool parseMeterRate(Napi::Env env, Napi::Value value, uint32_t *rate)
 {
-    _AudioSession *session = reinterpret_cast<_AudioSession *>(data);
-    Napi::Object result = constructor->New({});
-    Napi::ObjectWrap<AudioSessionObject>::Unwrap(result)->pSession = session;
-    result.Set("name", session->description());
-    result.Set("appName", session->appName());
-    result.Set("state", 1);
+    *rate = METER_RATE_DEFAULT;
+    if (value.IsUndefined() || value.IsNull())
+        return true;
 
-    return result;
-}
+    if (!value.IsObject())
+    {
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
 
-Napi::Value AudioSessionObject::GetVolume(const Napi::CallbackInfo &info)
-{
-    return Napi::Number::New(
-        info.Env(), reinterpret_cast<_AudioSession *>(pSession)->GetVolume());
+    Napi::Value v = value.As<Napi::Object>().Get("rateHz");
+    if (v.IsUndefined())
+        return true;
+    if (!v.IsNumber() || v.As<Napi::Number>().DoubleValue() < 1
+        || v.As<Napi::Number>().DoubleValue() > METER_RATE_MAX)
+    {
+        Napi::Error::New(env,
+            "Expected <rateHz> between 1 and "
+                + std::to_string(METER_RATE_MAX))
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    *rate = v.As<Napi::Number>().Uint32Value();
+    return true;
 }
 
-void AudioSessionObject::SetVolume(
-    const Napi::CallbackInfo &info, const Napi::Value &value)
+/**
+ *  \brief      Parses the `{ intervalMs }` object given to
+ *  `startLoudness()`.
+ */
+static bool parseLoudnessInterval(
+    Napi::Env env, Napi::Value value, uint32_t *intervalMs)
 {
-    float volume = value.As<Napi::Number>().FloatValue();
-    reinterpret_cast<_AudioSession *>(pSession)->SetVolume(volume);
+    *intervalMs = LOUDNESS_INTERVAL_DEFAULT;
+    if (value.IsUndefined() || value.IsNull())
+        return true;
+
+    if (!value.IsObject())
+    {
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Value v = value.As<Napi::Object>().Get("intervalMs");
+    if (v.IsUndefined())
+        return true;
+    if (!v.IsNumber()
+        || v.As<Napi::Number>().DoubleValue() < LOUDNESS_INTERVAL_MIN
+        || v.As<Napi::Number>().DoubleValue() > LOUDNESS_INTERVAL_MAX)
+    {
+        Napi::Error::New(env,
+            "Expected <intervalMs> between "
+                + std::to_string(LOUDNESS_INTERVAL_MIN) + " and "
+                + std::to_string(LOUDNESS_INTERVAL_MAX))
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    *intervalMs = v.As<Napi::Number>().Uint32Value();
+    return true;
 }
 
-Napi::Value AudioSessionObject::GetMute(const Napi::CallbackInfo &info)
+/**
+ *  \brief      Parses the `{ threshold, holdMs }` object given to
+ *  `startSilenceDetection()`.
+ */
+static bool parseSilenceOptions(
+    Napi::Env env, Napi::Value value, float *threshold, uint32_t *holdMs)
 {
-    return Napi::Boolean::New(
-        info.Env(), reinterpret_cast<_AudioSession *>(pSession)->GetMute());
+    *threshold = SILENCE_THRESHOLD_DEFAULT;
+    *holdMs = SILENCE_HOLD_DEFAULT;
+    if (value.IsUndefined() || value.IsNull())
+        return true;
+
+    if (!value.IsObject())
+    {
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object param = value.As<Napi::Object>();
+    Napi::Value t = param.Get("threshold");
+    Napi::Value h = param.Get("holdMs");
+    bool valid = (t.IsUndefined() || t.IsNumber())
+        && (h.IsUndefined() || h.IsNumber());
+    if (valid && t.IsNumber())
+    {
+        *threshold = t.As<Napi::Number>().FloatValue();
+        valid = *threshold >= 0.F && *threshold <= 1.F;
+    }
+    if (valid && h.IsNumber())
+    {
+        double hold = h.As<Napi::Number>().DoubleValue();
+        valid = hold >= SILENCE_HOLD_MIN && hold <= SILENCE_HOLD_MAX;
+        *holdMs = (uint32_t)hold;
+    }
+    if (!valid)
+    {
+        Napi::Error::New(env,
+            "Expected { threshold: number in [0, 1], holdMs: number between "
+                + std::to_string(SILENCE_HOLD_MIN) + " and "
+                + std::to_string(SILENCE_HOLD_MAX) + " }")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return true;
 }
 
-void AudioSessionObject::SetMute(
-    const Napi::CallbackInfo &info, const Napi::Value &value)
+/**
+ *  \brief      Parses the volume given to `setMaxVolume()`, null clearing
+ *  the cap.
+ */
+static bool parseMaxVolume(Napi::Env env, Napi::Value value, pa_volume_t *out)
 {
-    bool val = value.As<Napi::Boolean>().Value();
-    reinterpret_cast<_AudioSession *>(pSession)->SetMute(val);
+    *out = PA_VOLUME_INVALID;
+    if (value.IsNull() || value.IsUndefined())
+        return true;
+    if (!value.IsNumber()
+        || !ValidScalar(value.As<Napi::Number>().FloatValue()))
+    {
+        Napi::Error::New(env, "Expected <max> to be a valid volume or null")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    *out = VolumeFromScalar(value.As<Napi::Number>().FloatValue());
+    return true;
 }
 
-Napi::Value AudioSessionObject::GetChannelVolume(
-    const Napi::CallbackInfo &info)
+static const struct
 {
-    Napi::Object result = Napi::Object::New(info.Env());
-    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
-    VolumeBalance balance = session->GetVolumeBalance();
-    result.Set("right", balance.right);
-    result.Set("left", balance.left);
-    return result;
-}
+    const char *name;
+    pa_sample_format_t format;
+} captureFormats[] = {
+    {"s16le", PA_SAMPLE_S16LE},
+    {"s32le", PA_SAMPLE_S32LE},
+    {"float32le", PA_SAMPLE_FLOAT32LE},
+};
 
-void AudioSessionObject::SetChannelVolume(
-    const Napi::CallbackInfo &info, const Napi::Value &value)
+/**
+ *  \brief      Parses a `{ format, rate, channels }` object, every field
+ *  defaulting to 16 bit stereo at 48 kHz.
+ */
+static bool parseSampleSpec(
+    Napi::Env env, Napi::Value value, pa_sample_spec *spec)
 {
-    Napi::Object param = value.As<Napi::Object>();
-    if (!param.Has("right") || !param.Has("left"))
+    *spec = pa_sample_spec {PA_SAMPLE_S16LE, 48000, 2};
+    if (value.IsUndefined() || value.IsNull())
+        return true;
+    if (!value.IsObject())
     {
-        return;
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
     }
-    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
-    VolumeBalance balance
-        = {param.Get("right").As<Napi::Number>().FloatValue(),
-            param.Get("left").As<Napi::Number>().FloatValue(), true};
+
+    Napi::Object param = value.As<Napi::Object>();
+    Napi::Value format = param.Get("format");
+    if (!format.IsUndefined())
+    {
+        std::string name = format.IsString()
+            ? format.As<Napi::String>().Utf8Value()
+            : std::string();
+        spec->format = PA_SAMPLE_INVALID;
+        for (auto &entry : captureFormats)
+        {
+            if (name == entry.name)
+                spec->format = entry.format;
+        }
+    }
+
+    Napi::Value rate = param.Get("rate");
+    Napi::Value channels = param.Get("channels");
+    if (rate.IsNumber())
+        spec->rate = rate.As<Napi::Number>().Uint32Value();
+    if (channels.IsNumber())
+        spec->channels = (uint8_t)std::min(
+            channels.As<Napi::Number>().Uint32Value(), (uint32_t)UINT8_MAX);
+
+    if (!pa_sample_spec_valid(spec)
+        || (!rate.IsUndefined() && !rate.IsNumber())
+        || (!channels.IsUndefined() && !channels.IsNumber()))
+    {
+        Napi::Error::New(env,
+            "Expected { format: 's16le' | 's32le' | 'float32le', rate, "
+            "channels } within the server limits")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return true;
+}
+
+Napi::Value MixerObject::UploadSample(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (!info[0].IsString()
+        || !(info[1].IsArrayBuffer() || info[1].IsTypedArray()))
+    {
+        Napi::Error::New(env, "Expected <name> <ArrayBuffer | TypedArray>")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    pa_sample_spec spec;
+    if (!parseSampleSpec(env, info[2], &spec))
+        return Napi::Boolean::New(env, false);
+
+    const uint8_t *data;
+    size_t length;
+    if (info[1].IsArrayBuffer())
+    {
+        Napi::ArrayBuffer buffer = info[1].As<Napi::ArrayBuffer>();
+        data = static_cast<const uint8_t *>(buffer.Data());
+        length = buffer.ByteLength();
+    }
+    else
+    {
+        Napi::TypedArray array = info[1].As<Napi::TypedArray>();
+        data = static_cast<const uint8_t *>(array.ArrayBuffer().Data())
+            + array.ByteOffset();
+        length = array.ByteLength();
+    }
+    if (length == 0 || length % pa_frame_size(&spec) != 0)
+    {
+        Napi::Error::New(env, "Expected a whole number of frames")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    return Napi::Boolean::New(
+        env, mixer->UploadSample(name, spec, data, length));
+}
+
+Napi::Value MixerObject::RemoveSample(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (!info[0].IsString())
+    {
+        Napi::Error::New(env, "Expected <name> to be a string")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    return Napi::Boolean::New(env, mixer->RemoveSample(name));
+}
+
+static void releaseRing(
+    Napi::Env, void *, std::shared_ptr<SampleRing> *owner)
+{
+    delete owner;
+}
+
+/**
+ *  \brief      Exposes a ring as an external ArrayBuffer, which shares the
+ *  ownership of the ring since it may outlive the meter.
+ */
+static Napi::Value ringToArrayBuffer(
+    Napi::Env env, const std::shared_ptr<SampleRing> &ring)
+{
+    return Napi::ArrayBuffer::New(env, ring->Data(), ring->Size(),
+        releaseRing, new std::shared_ptr<SampleRing>(ring));
+}
+
+Napi::Value MixerObject::RegisterEvent(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || info.Length() > 4 || !info[0].IsString()
+        || !info[2].IsFunction())
+    {
+        Napi::Error::New(
+            env, "Expected <event-type> <selector> <function> [options]")
+            .ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+
+    EventType eventType;
+    if (!parseEventType(info[0].As<Napi::String>().Utf8Value(), &eventType))
+        return Napi::Number::New(env, -1);
+
+    Selector selector;
+    ListenerOptions options;
+    if (!ParseSelector(env, info[1], &selector)
+        || !ParseListenerOptions(env, info[3], &options))
+        return Napi::Number::New(env, -1);
+
+    Napi::Function func = info[2].As<Napi::Function>();
+    TSFN ref = TSFN::New(env, func, "sound-mixer-event", 0, 1,
+        new Napi::Reference<Napi::Value>(Napi::Persistent(info.This())));
+
+    int handler
+        = eventPool->RegisterSelector(selector, eventType, ref, options);
+    return Napi::Number::New(env, handler);
+}
+
+Napi::Value MixerObject::RemoveEvent(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 2 || !info[0].IsString() || !info[1].IsNumber())
+    {
+        Napi::Error::New(env, "Expected <event-type> <callback-handler>")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    EventType eventType;
+    if (!parseEventType(info[0].As<Napi::String>().Utf8Value(), &eventType))
+        return Napi::Boolean::New(env, false);
+    int handler = info[1].As<Napi::Number>().Int32Value();
+
+    return Napi::Boolean::New(
+        env, eventPool->RemoveSelector(eventType, handler));
+}
+
+Napi::Value MixerObject::ResolveTarget(Napi::Env env, Target target)
+{
+    // a live wrapper costs no round trip, which matters for the meters of
+    // every session of a selector
+    Napi::Object cached = wrappers->Find(wrappers->KeyOf(target));
+    if (!cached.IsEmpty())
+        return cached;
+
+    if (target.kind == TARGET_DEVICE)
+    {
+        _Device *dev = mixer->GetDeviceByIndex(target.index, target.type);
+        if (dev != nullptr)
+            return DeviceObject::New(env, dev);
+    }
+    else if (target.kind == TARGET_SESSION)
+    {
+        _AudioSession *session
+            = mixer->GetKnownAudioSession(target.index, target.type);
+        if (session != nullptr)
+            return AudioSessionObject::New(env, session);
+    }
+
+    return env.Null();
+}
+
+Napi::Object DeviceObject::Init(Napi::Env env, Napi::Object exports)
+{
+
+    constructor = new Napi::FunctionReference();
+    *constructor = Napi::Persistent(GetClass(env));
+
+    return exports;
+}
+
+static Napi::Value rawChannelsToArray(Napi::Env env, const pa_cvolume &vol)
+{
+    Napi::Uint32Array result = Napi::Uint32Array::New(env, vol.channels);
+    std::memcpy(result.Data(), vol.values, vol.channels * sizeof(uint32_t));
+    return result;
+}
+
+/**
+ *  \brief      Reads either a single pa_volume_t or a Uint32Array holding
+ *  one per channel, without any scale conversion.
+ */
+static bool parseRawVolume(Napi::Env env, Napi::Value value, pa_cvolume *out)
+{
+    if (value.IsNumber())
+    {
+        int64_t volume = value.As<Napi::Number>().Int64Value();
+        pa_cvolume_set(out, 1,
+            (pa_volume_t)std::min<int64_t>(
+                std::max<int64_t>(volume, 0), PA_VOLUME_MAX));
+        return true;
+    }
+
+    if (!isTypedArrayOf(value, napi_uint32_array))
+    {
+        Napi::Error::New(env, "Expected <volume> or a Uint32Array")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Uint32Array values = value.As<Napi::Uint32Array>();
+    size_t count = std::min(values.ElementLength(), (size_t)PA_CHANNELS_MAX);
+    if (count == 0)
+    {
+        Napi::Error::New(env, "Expected at least one volume")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    out->channels = (uint8_t)count;
+    std::memcpy(out->values, values.Data(), count * sizeof(uint32_t));
+
+    return true;
+}
+
+Napi::Function DeviceObject::GetClass(Napi::Env env)
+{
+    Napi::Function func = DefineClass(env, "Device",
+        {InstanceAccessor<&DeviceObject::GetVolume, &DeviceObject::SetVolume>(
+             "volume"),
+            InstanceAccessor<&DeviceObject::GetMute, &DeviceObject::SetMute>(
+                "mute"),
+            InstanceAccessor<&DeviceObject::GetChannelVolume,
+                &DeviceObject::SetChannelVolume>("balance"),
+            InstanceAccessor<&DeviceObject::GetChannels,
+                &DeviceObject::SetChannels>("channels"),
+            InstanceAccessor<&DeviceObject::GetRawVolume>("rawVolume"),
+            InstanceAccessor<&DeviceObject::GetRawChannels>("rawChannels"),
+            InstanceAccessor<&DeviceObject::GetMeterBuffer>("meterBuffer"),
+            InstanceAccessor<&DeviceObject::GetSpectrumBuffer>(
+                "spectrumBuffer"),
+            InstanceAccessor<&DeviceObject::GetSessions>("sessions"),
+            InstanceAccessor<&DeviceObject::GetName>("name"),
+            InstanceAccessor<&DeviceObject::GetType>("type"),
+            InstanceMethod<&DeviceObject::RegisterEvent>("on"),
+            InstanceMethod<&DeviceObject::RemoveEvent>("removeListener"),
+            InstanceMethod<&DeviceObject::StepVolume>("stepVolume"),
+            InstanceMethod<&DeviceObject::SetRawVolume>("setRawVolume"),
+            InstanceMethod<&DeviceObject::StartMeter>("startMeter"),
+            InstanceMethod<&DeviceObject::StopMeter>("stopMeter"),
+            InstanceMethod<&DeviceObject::OpenCapture>("openCapture"),
+            InstanceMethod<&DeviceObject::StartSpectrum>("startSpectrum"),
+            InstanceMethod<&DeviceObject::StopSpectrum>("stopSpectrum"),
+            InstanceMethod<&DeviceObject::StartLoudness>("startLoudness"),
+            InstanceMethod<&DeviceObject::StopLoudness>("stopLoudness"),
+            InstanceMethod<&DeviceObject::SetMaxVolume>("setMaxVolume"),
+            InstanceMethod<&DeviceObject::PlaySample>("playSample"),
+            InstanceMethod<&DeviceObject::Dispose>("dispose")});
+    AliasDisposeSymbol(func);
+
+    return func;
+}
+
+DeviceObject::DeviceObject(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<DeviceObject>(info)
+{
+}
+
+DeviceDescriptor DeviceObject::Desc()
+{
+    return reinterpret_cast<_Device *>(pDevice)->ToDeviceDescriptor();
+}
+
+DeviceObject::~DeviceObject()
+{
+    MixerObject::wrappers->Erase(key, this);
+    ReleaseMeter();
+    ReleaseSpectrum();
+    ReleaseLoudness();
+    delete reinterpret_cast<_Device *>(pDevice);
+}
+
+bool DeviceObject::EnsureAlive(Napi::Env env)
+{
+    if (pDevice != NULL)
+        return true;
+
+    Napi::Error::New(env, "This Device has been disposed")
+        .ThrowAsJavaScriptException();
+    return false;
+}
+
+Napi::Value DeviceObject::Dispose(const Napi::CallbackInfo &info)
+{
+    if (pDevice == NULL)
+        return info.Env().Undefined();
+
+    DeviceDescriptor desc = Desc();
+    for (auto &handler : handlers)
+        MixerObject::eventPool->RemoveEvent(
+            desc, handler.second, handler.first);
+    handlers.clear();
+    if (metering)
+    {
+        ReleaseMeter();
+        Unref();
+    }
+    if (spectrum != NULL)
+    {
+        ReleaseSpectrum();
+        Unref();
+    }
+    if (loudness)
+    {
+        ReleaseLoudness();
+        Unref();
+    }
+
+    MixerObject::wrappers->Erase(key, this);
+    delete reinterpret_cast<_Device *>(pDevice);
+    pDevice = NULL;
+
+    return info.Env().Undefined();
+}
+
+bool DeviceObject::GetTarget(Target *out)
+{
+    if (pDevice == NULL)
+        return false;
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    *out = Target {TARGET_DEVICE, dev->type(), dev->index};
+    return true;
+}
+
+Napi::Value DeviceObject::New(Napi::Env env, void *device)
+{
+    _Device *dev = reinterpret_cast<_Device *>(device);
+    WrapperCache::Key key = MixerObject::wrappers->KeyOf(
+        Target {TARGET_DEVICE, dev->type(), dev->index});
+    Napi::Object cached = MixerObject::wrappers->Find(key);
+    if (!cached.IsEmpty())
+    {
+        delete dev;
+        return cached;
+    }
+
+    Napi::Object result = constructor->New({});
+    DeviceObject *obj = Napi::ObjectWrap<DeviceObject>::Unwrap(result);
+    obj->pDevice = dev;
+    obj->name = dev->friendlyName();
+    obj->type = (int)dev->type();
+    obj->key = key;
+    MixerObject::wrappers->Insert(key, result, obj);
+
+    return result;
+}
+
+Napi::Value DeviceObject::GetName(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::String::New(info.Env(), "");
+
+    return Napi::String::New(info.Env(), name);
+}
+
+Napi::Value DeviceObject::GetType(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    return Napi::Number::New(info.Env(), type);
+}
+
+Napi::Value DeviceObject::GetVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    return Napi::Number::New(info.Env(), dev->GetVolume());
+}
+
+void DeviceObject::SetVolume(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    if (!EnsureAlive(info.Env()))
+        return;
+
+    float volume = value.As<Napi::Number>().FloatValue();
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    dev->SetVolume(volume);
+}
+
+Napi::Value DeviceObject::StepVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsNumber())
+    {
+        Napi::Error::New(env, "Expected <delta>").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+
+    float delta = info[0].As<Napi::Number>().FloatValue();
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    return Napi::Number::New(env, dev->StepVolume(delta));
+}
+
+Napi::Value DeviceObject::GetMute(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    return Napi::Boolean::New(info.Env(), dev->GetMute());
+}
+
+void DeviceObject::SetMute(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    if (!EnsureAlive(info.Env()))
+        return;
+
+    bool val = value.As<Napi::Boolean>().Value();
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    dev->SetMute(val);
+}
+
+Napi::Value DeviceObject::RegisterEvent(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || info.Length() > 3 || !info[0].IsString()
+        || !info[1].IsFunction())
+    {
+        Napi::Error::New(env, "Expected <event-type> <function> [options]")
+            .ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+
+    EventType eventType;
+    if (!parseEventType(info[0].As<Napi::String>().Utf8Value(), &eventType))
+        return Napi::Number::New(env, -1);
+
+    ListenerOptions options;
+    if (!ParseListenerOptions(env, info[2], &options))
+        return Napi::Number::New(env, -1);
+
+    Napi::Function func = info[1].As<Napi::Function>();
+    TSFN ref = TSFN::New(env, func, "sound-mixer-event", 0, 1,
+        new Napi::Reference<Napi::Value>(Napi::Persistent(info.This())));
+
+    int handler = MixerObject::eventPool->RegisterEvent(
+        Desc(), eventType, ref, options);
+    handlers[handler] = eventType;
+    return Napi::Number::New(env, handler);
+}
+
+Napi::Value DeviceObject::RemoveEvent(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    Napi::Env env = info.Env();
+    // expects EventType and event id
+    if (info.Length() != 2 || !info[0].IsString() || !info[1].IsNumber())
+    {
+        Napi::Error::New(env, "Expected <event-type> <callback-handler>")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+    EventType eventType;
+    if (!parseEventType(info[0].As<Napi::String>().Utf8Value(), &eventType))
+        return Napi::Boolean::New(env, false);
+    int handler = info[1].As<Napi::Number>().Int32Value();
+    bool res = MixerObject::eventPool->RemoveEvent(Desc(), eventType, handler);
+    if (res)
+        handlers.erase(handler);
+
+    return Napi::Boolean::New(env, res);
+}
+
+Napi::Value DeviceObject::StartMeter(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    uint32_t rate;
+    if (!parseMeterRate(info.Env(), info[0], &rate))
+        return Napi::Boolean::New(info.Env(), false);
+
+    // a wrapper holds at most one reference on the shared meter, and is
+    // kept alive while it does since nothing else may reference it
+    if (!metering)
+    {
+        metering = reinterpret_cast<_Device *>(pDevice)->StartMeter(rate);
+        if (metering)
+            Ref();
+    }
+
+    return Napi::Boolean::New(info.Env(), metering);
+}
+
+Napi::Value DeviceObject::StopMeter(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    bool stopped = metering;
+    if (metering)
+    {
+        ReleaseMeter();
+        Unref();
+    }
+
+    return Napi::Boolean::New(info.Env(), stopped);
+}
+
+Napi::Value DeviceObject::GetMeterBuffer(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()) || !metering)
+        return info.Env().Null();
+
+    if (ring == nullptr)
+    {
+        ring = reinterpret_cast<_Device *>(pDevice)->AttachMeterRing(
+            METER_RING_SLOTS);
+        if (ring == nullptr)
+            return info.Env().Null();
+        ringBuffer = Napi::Persistent(
+            ringToArrayBuffer(info.Env(), ring).As<Napi::Object>());
+    }
+
+    return ringBuffer.Value();
+}
+
+/**
+ *  \brief      Parses the `{ format, rate, channels, fragmentMs }` object
+ *  given to `openCapture()`.
+ */
+static bool parseCaptureOptions(Napi::Env env, Napi::Value value,
+    pa_sample_spec *spec, uint32_t *fragmentMs)
+{
+    *fragmentMs = 10;
+    if (!parseSampleSpec(env, value, spec))
+        return false;
+    if (value.IsUndefined() || value.IsNull())
+        return true;
+
+    Napi::Value fragment = value.As<Napi::Object>().Get("fragmentMs");
+    if (fragment.IsNumber())
+        *fragmentMs = fragment.As<Napi::Number>().Uint32Value();
+    if (*fragmentMs == 0 || *fragmentMs > 1000
+        || (!fragment.IsUndefined() && !fragment.IsNumber()))
+    {
+        Napi::Error::New(env, "Expected fragmentMs between 1 and 1000")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return true;
+}
+
+Napi::Value DeviceObject::OpenCapture(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || info.Length() > 2
+        || !info[info.Length() - 1].IsFunction())
+    {
+        Napi::Error::New(env, "Expected [options] <function>")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    pa_sample_spec spec;
+    uint32_t fragmentMs;
+    Napi::Value options = info.Length() == 2 ? info[0] : env.Undefined();
+    if (!parseCaptureOptions(env, options, &spec, &fragmentMs))
+        return env.Null();
+
+    return CaptureObject::New(env, reinterpret_cast<_Device *>(pDevice),
+        spec, fragmentMs, info[info.Length() - 1].As<Napi::Function>());
+}
+
+typedef struct
+{
+    uint32_t size;
+    uint32_t hop;
+    SpectrumWindow window;
+    uint32_t bands;
+} SpectrumOptions;
+
+static const struct
+{
+    const char *name;
+    SpectrumWindow window;
+} spectrumWindows[] = {
+    {"rect", WINDOW_RECT},
+    {"hann", WINDOW_HANN},
+    {"hamming", WINDOW_HAMMING},
+    {"blackman", WINDOW_BLACKMAN},
+};
+
+/**
+ *  \brief      Parses the `{ size, hop, window, bands }` object given to
+ *  `startSpectrum()`, hop defaulting to half the size.
+ */
+static bool parseSpectrumOptions(
+    Napi::Env env, Napi::Value value, SpectrumOptions *options)
+{
+    *options = SpectrumOptions {2048, 0, WINDOW_HANN, 32};
+    if (!value.IsUndefined() && !value.IsNull() && !value.IsObject())
+    {
+        Napi::Error::New(env, "Expected <options> to be an object")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    bool valid = true;
+    if (value.IsObject())
+    {
+        Napi::Object param = value.As<Napi::Object>();
+        Napi::Value size = param.Get("size");
+        Napi::Value hop = param.Get("hop");
+        Napi::Value window = param.Get("window");
+        Napi::Value bands = param.Get("bands");
+        valid = (size.IsUndefined() || size.IsNumber())
+            && (hop.IsUndefined() || hop.IsNumber())
+            && (window.IsUndefined() || window.IsString())
+            && (bands.IsUndefined() || bands.IsNumber());
+
+        if (size.IsNumber())
+            options->size = size.As<Napi::Number>().Uint32Value();
+        if (hop.IsNumber())
+            options->hop = hop.As<Napi::Number>().Uint32Value();
+        if (bands.IsNumber())
+            options->bands = bands.As<Napi::Number>().Uint32Value();
+        if (window.IsString())
+        {
+            std::string name = window.As<Napi::String>().Utf8Value();
+            bool known = false;
+            for (auto &entry : spectrumWindows)
+            {
+                if (name == entry.name)
+                {
+                    options->window = entry.window;
+                    known = true;
+                }
+            }
+            valid = valid && known;
+        }
+    }
+    if (options->hop == 0)
+        options->hop = options->size / 2;
+
+    uint32_t size = options->size;
+    if (!valid || size < SPECTRUM_SIZE_MIN || size > SPECTRUM_SIZE_MAX
+        || (size & (size - 1)) != 0 || options->hop > size
+        || options->bands == 0 || options->bands > size / 2
+        || options->bands > SPECTRUM_BANDS_MAX)
+    {
+        Napi::Error::New(env,
+            "Expected { size: power of two between "
+                + std::to_string(SPECTRUM_SIZE_MIN) + " and "
+                + std::to_string(SPECTRUM_SIZE_MAX)
+                + ", hop <= size, window: 'rect' | 'hann' | 'hamming' | "
+                  "'blackman', bands <= "
+                + std::to_string(SPECTRUM_BANDS_MAX) + " }")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return true;
+}
+
+Napi::Value DeviceObject::StartSpectrum(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    SpectrumOptions options;
+    if (!parseSpectrumOptions(info.Env(), info[0], &options))
+        return Napi::Boolean::New(info.Env(), false);
+
+    // restarting applies the new options
+    if (spectrum != NULL)
+    {
+        ReleaseSpectrum();
+        Unref();
+    }
+
+    analyser.reset(new SpectrumAnalyser(options.size, options.hop,
+        options.window, options.bands, SPECTRUM_RATE, SPECTRUM_RING_SLOTS));
+    pa_sample_spec spec {PA_SAMPLE_FLOAT32NE, SPECTRUM_RATE, 1};
+    uint32_t fragmentMs = (uint32_t)((uint64_t)options.hop * 1000
+        / SPECTRUM_RATE);
+    spectrum = reinterpret_cast<_Device *>(pDevice)->OpenCapture(spec,
+        std::min(std::max(fragmentMs, 1U), 1000U), OnSpectrumData,
+        analyser.get());
+    if (spectrum == NULL)
+    {
+        analyser.reset();
+        return Napi::Boolean::New(info.Env(), false);
+    }
+
+    // kept alive while the analyser runs, nothing else may reference it
+    Ref();
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+Napi::Value DeviceObject::StopSpectrum(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    bool stopped = spectrum != NULL;
+    if (stopped)
+    {
+        ReleaseSpectrum();
+        Unref();
+    }
+
+    return Napi::Boolean::New(info.Env(), stopped);
+}
+
+Napi::Value DeviceObject::GetSpectrumBuffer(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()) || spectrum == NULL)
+        return info.Env().Null();
+
+    if (spectrumBuffer.IsEmpty())
+        spectrumBuffer = Napi::Persistent(
+            ringToArrayBuffer(info.Env(), analyser->Ring())
+                .As<Napi::Object>());
+
+    return spectrumBuffer.Value();
+}
+
+void DeviceObject::OnSpectrumData(
+    void *userdata, const void *data, size_t length)
+{
+    if (data == NULL)
+        return;
+
+    reinterpret_cast<SpectrumAnalyser *>(userdata)->Feed(
+        reinterpret_cast<const float *>(data), length / sizeof(float));
+}
+
+Napi::Value DeviceObject::StartLoudness(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    uint32_t intervalMs;
+    if (!parseLoudnessInterval(info.Env(), info[0], &intervalMs))
+        return Napi::Boolean::New(info.Env(), false);
+
+    if (!loudness)
+    {
+        loudness
+            = reinterpret_cast<_Device *>(pDevice)->StartLoudness(intervalMs);
+        if (loudness)
+            Ref();
+    }
+
+    return Napi::Boolean::New(info.Env(), loudness);
+}
+
+Napi::Value DeviceObject::StopLoudness(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    bool stopped = loudness;
+    if (loudness)
+    {
+        ReleaseLoudness();
+        Unref();
+    }
+
+    return Napi::Boolean::New(info.Env(), stopped);
+}
+
+Napi::Value DeviceObject::SetMaxVolume(const Napi::CallbackInfo &info)
+{
+    pa_volume_t max;
+    if (!EnsureAlive(info.Env())
+        || !parseMaxVolume(info.Env(), info[0], &max))
+        return Napi::Boolean::New(info.Env(), false);
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    return Napi::Boolean::New(info.Env(), dev->SetMaxVolume(max));
+}
+
+Napi::Value DeviceObject::PlaySample(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (!EnsureAlive(env))
+        return Napi::Boolean::New(env, false);
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    if (dev->type() != DeviceType::OUTPUT)
+    {
+        Napi::Error::New(env, "Samples only play on render devices")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+    if (!info[0].IsString()
+        || !(info[1].IsUndefined()
+            || (info[1].IsNumber()
+                && ValidScalar(info[1].As<Napi::Number>().FloatValue()))))
+    {
+        Napi::Error::New(env, "Expected <name> [volume]")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    // the server plays the sample at its own volume when none is given
+    pa_volume_t volume = info[1].IsUndefined()
+        ? PA_VOLUME_INVALID
+        : VolumeFromScalar(info[1].As<Napi::Number>().FloatValue());
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    return Napi::Boolean::New(env, dev->PlaySample(name, volume));
+}
+
+void DeviceObject::ReleaseLoudness()
+{
+    if (!loudness)
+        return;
+
+    reinterpret_cast<_Device *>(pDevice)->StopLoudness();
+    loudness = false;
+}
+
+void DeviceObject::ReleaseSpectrum()
+{
+    if (spectrum == NULL)
+        return;
+
+    // no data callback runs once the capture is closed
+    spectrum->monitor->CloseCapture(spectrum);
+    spectrum = NULL;
+    analyser.reset();
+    spectrumBuffer.Reset();
+}
+
+void DeviceObject::ReleaseMeter()
+{
+    if (!metering)
+        return;
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    if (ring != nullptr)
+        dev->DetachMeterRing(ring);
+    ring.reset();
+    ringBuffer.Reset();
+    dev->StopMeter();
+    metering = false;
+}
+
+Napi::Value DeviceObject::GetChannelVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    VolumeBalance balance = dev->GetVolumeBalance();
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
+    Napi::Object result = Napi::Object::New(info.Env());
+    result.Set(keys->right.Value(), balance.right);
+    result.Set(keys->left.Value(), balance.left);
+    result.Set(keys->stereo.Value(), balance.stereo);
+    return result;
+}
+
+void DeviceObject::SetChannelVolume(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    if (!EnsureAlive(info.Env()))
+        return;
+
+    Napi::Object param = value.As<Napi::Object>();
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
+    if (!param.Has(keys->right.Value()) || !param.Has(keys->left.Value()))
+    {
+        return;
+    }
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    VolumeBalance balance
+        = {param.Get(keys->right.Value()).As<Napi::Number>().FloatValue(),
+            param.Get(keys->left.Value()).As<Napi::Number>().FloatValue(),
+            true};
+
+    dev->SetVolumeBalance(balance);
+}
+
+Napi::Value DeviceObject::GetChannels(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    return channelsToObject(info.Env(), dev->GetChannelVolumes());
+}
+
+void DeviceObject::SetChannels(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    if (!EnsureAlive(info.Env()))
+        return;
+
+    ChannelVolumes values;
+    if (!parseChannels(info.Env(), value, &values))
+        return;
+    reinterpret_cast<_Device *>(pDevice)->SetChannelVolumes(values);
+}
+
+Napi::Value DeviceObject::GetRawVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    pa_cvolume vol = reinterpret_cast<_Device *>(pDevice)->GetRawVolume();
+    return Napi::Number::New(info.Env(), pa_cvolume_avg(&vol));
+}
+
+Napi::Value DeviceObject::GetRawChannels(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
+    pa_cvolume vol = reinterpret_cast<_Device *>(pDevice)->GetRawVolume();
+    return rawChannelsToArray(info.Env(), vol);
+}
+
+Napi::Value DeviceObject::SetRawVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Undefined();
+
+    pa_cvolume values;
+    if (parseRawVolume(info.Env(), info[0], &values))
+        reinterpret_cast<_Device *>(pDevice)->SetRawVolume(values);
+
+    return info.Env().Undefined();
+}
+
+Napi::Value DeviceObject::GetSessions(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Array::New(info.Env());
+
+    _Device *dev = reinterpret_cast<_Device *>(pDevice);
+    Napi::Array result = Napi::Array::New(info.Env());
+    int i = 0;
+    for (_AudioSession *s : dev->GetAudioSessions())
+    {
+        result.Set(i++, AudioSessionObject::New(info.Env(), s));
+    }
+
+    return result;
+}
+
+AudioSessionObject::AudioSessionObject(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<AudioSessionObject>(info)
+{
+}
+
+Napi::Function AudioSessionObject::GetClass(Napi::Env env)
+{
+    Napi::Function func = DefineClass(env, "AudioSession",
+        {InstanceAccessor<&AudioSessionObject::GetMute,
+             &AudioSessionObject::SetMute>("mute"),
+            InstanceAccessor<&AudioSessionObject::GetVolume,
+                &AudioSessionObject::SetVolume>("volume"),
+            InstanceAccessor<&AudioSessionObject::GetChannelVolume,
+                &AudioSessionObject::SetChannelVolume>("balance"),
+            InstanceAccessor<&AudioSessionObject::GetChannels,
+                &AudioSessionObject::SetChannels>("channels"),
+            InstanceAccessor<&AudioSessionObject::GetRawVolume>("rawVolume"),
+            InstanceAccessor<&AudioSessionObject::GetRawChannels>(
+                "rawChannels"),
+            InstanceAccessor<&AudioSessionObject::GetMeterBuffer>(
+                "meterBuffer"),
+            InstanceAccessor<&AudioSessionObject::GetName>("name"),
+            InstanceAccessor<&AudioSessionObject::GetAppName>("appName"),
+            InstanceAccessor<&AudioSessionObject::GetState>("state"),
+            InstanceMethod<&AudioSessionObject::StepVolume>("stepVolume"),
+            InstanceMethod<&AudioSessionObject::SetRawVolume>("setRawVolume"),
+            InstanceMethod<&AudioSessionObject::StartMeter>("startMeter"),
+            InstanceMethod<&AudioSessionObject::StopMeter>("stopMeter"),
+            InstanceMethod<&AudioSessionObject::StartLoudness>(
+                "startLoudness"),
+            InstanceMethod<&AudioSessionObject::StopLoudness>(
+                "stopLoudness"),
+            InstanceMethod<&AudioSessionObject::StartSilenceDetection>(
+                "startSilenceDetection"),
+            InstanceMethod<&AudioSessionObject::StopSilenceDetection>(
+                "stopSilenceDetection"),
+            InstanceMethod<&AudioSessionObject::SetMaxVolume>(
+                "setMaxVolume"),
+            InstanceMethod<&AudioSessionObject::MoveTo>("moveTo"),
+            InstanceMethod<&AudioSessionObject::Dispose>("dispose")});
+    AliasDisposeSymbol(func);
+
+    return func;
+}
+
+Napi::Object AudioSessionObject::Init(Napi::Env env, Napi::Object exports)
+{
+    constructor = new Napi::FunctionReference();
+    *constructor = Napi::Persistent(GetClass(env));
+
+    return exports;
+}
+
+AudioSessionObject::~AudioSessionObject()
+{
+    MixerObject::wrappers->Erase(key, this);
+    ReleaseMeter();
+    ReleaseLoudness();
+    ReleaseSilenceDetector();
+    delete reinterpret_cast<_AudioSession *>(pSession);
+}
+
+bool AudioSessionObject::EnsureAlive(Napi::Env env)
+{
+    if (pSession != NULL)
+        return true;
+
+    Napi::Error::New(env, "This AudioSession has been disposed")
+        .ThrowAsJavaScriptException();
+    return false;
+}
+
+Napi::Value AudioSessionObject::Dispose(const Napi::CallbackInfo &info)
+{
+    if (pSession == NULL)
+        return info.Env().Undefined();
+
+    if (metering)
+    {
+        ReleaseMeter();
+        Unref();
+    }
+    if (loudness)
+    {
+        ReleaseLoudness();
+        Unref();
+    }
+    if (detecting)
+    {
+        ReleaseSilenceDetector();
+        Unref();
+    }
+
+    MixerObject::wrappers->Erase(key, this);
+    delete reinterpret_cast<_AudioSession *>(pSession);
+    pSession = NULL;
+
+    return info.Env().Undefined();
+}
+
+bool AudioSessionObject::GetTarget(Target *out)
+{
+    if (pSession == NULL)
+        return false;
+
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    *out = Target {TARGET_SESSION, session->type(), session->index};
+    return true;
+}
+
+Napi::Value AudioSessionObject::New(Napi::Env env, void *data)
+{
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(data);
+    WrapperCache::Key key = MixerObject::wrappers->KeyOf(
+        Target {TARGET_SESSION, session->type(), session->index});
+    Napi::Object result = MixerObject::wrappers->Find(key);
+    AudioSessionObject *obj;
+    if (!result.IsEmpty())
+    {
+        // the names of a cached wrapper follow the EventMonitor
+        delete session;
+        return result;
+    }
+
+    result = constructor->New({});
+    obj = Napi::ObjectWrap<AudioSessionObject>::Unwrap(result);
+    obj->pSession = session;
+    Subject subject;
+    if (session->LatestSubject(&subject))
+    {
+        obj->name = subject.name;
+        obj->appName = subject.appName;
+    }
+    else
+    {
+        obj->name = session->description();
+        obj->appName = session->appName();
+    }
+    obj->key = key;
+    MixerObject::wrappers->Insert(key, result, obj);
+
+    return result;
+}
+
+void AudioSessionObject::RefreshNames()
+{
+    // streams may rename themselves
+    Subject subject;
+    if (reinterpret_cast<_AudioSession *>(pSession)->LatestSubject(&subject))
+    {
+        name = subject.name;
+        appName = subject.appName;
+    }
+}
+
+Napi::Value AudioSessionObject::GetName(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::String::New(info.Env(), "");
+
+    RefreshNames();
+    return Napi::String::New(info.Env(), name);
+}
+
+Napi::Value AudioSessionObject::GetAppName(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::String::New(info.Env(), "");
+
+    RefreshNames();
+    return Napi::String::New(info.Env(), appName);
+}
+
+Napi::Value AudioSessionObject::GetState(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    return Napi::Number::New(info.Env(),
+        reinterpret_cast<_AudioSession *>(pSession)->GetState());
+}
+
+Napi::Value AudioSessionObject::GetVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    return Napi::Number::New(
+        info.Env(), reinterpret_cast<_AudioSession *>(pSession)->GetVolume());
+}
+
+void AudioSessionObject::SetVolume(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    if (!EnsureAlive(info.Env()))
+        return;
+
+    float volume = value.As<Napi::Number>().FloatValue();
+    reinterpret_cast<_AudioSession *>(pSession)->SetVolume(volume);
+}
+
+Napi::Value AudioSessionObject::StepVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsNumber())
+    {
+        Napi::Error::New(env, "Expected <delta>").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+
+    float delta = info[0].As<Napi::Number>().FloatValue();
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    return Napi::Number::New(env, session->StepVolume(delta));
+}
+
+Napi::Value AudioSessionObject::GetMute(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    return Napi::Boolean::New(
+        info.Env(), reinterpret_cast<_AudioSession *>(pSession)->GetMute());
+}
+
+void AudioSessionObject::SetMute(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    if (!EnsureAlive(info.Env()))
+        return;
+
+    bool val = value.As<Napi::Boolean>().Value();
+    reinterpret_cast<_AudioSession *>(pSession)->SetMute(val);
+}
+
+Napi::Value AudioSessionObject::GetChannelVolume(
+    const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
+    Napi::Object result = Napi::Object::New(info.Env());
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    VolumeBalance balance = session->GetVolumeBalance();
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
+    result.Set(keys->right.Value(), balance.right);
+    result.Set(keys->left.Value(), balance.left);
+    return result;
+}
+
+void AudioSessionObject::SetChannelVolume(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    if (!EnsureAlive(info.Env()))
+        return;
+
+    Napi::Object param = value.As<Napi::Object>();
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
+    if (!param.Has(keys->right.Value()) || !param.Has(keys->left.Value()))
+    {
+        return;
+    }
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    VolumeBalance balance
+        = {param.Get(keys->right.Value()).As<Napi::Number>().FloatValue(),
+            param.Get(keys->left.Value()).As<Napi::Number>().FloatValue(),
+            true};
 
     session->SetVolumeBalance(balance);
 }
 
+Napi::Value AudioSessionObject::GetChannels(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    return channelsToObject(info.Env(), session->GetChannelVolumes());
+}
+
+void AudioSessionObject::SetChannels(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    if (!EnsureAlive(info.Env()))
+        return;
+
+    ChannelVolumes values;
+    if (!parseChannels(info.Env(), value, &values))
+        return;
+    reinterpret_cast<_AudioSession *>(pSession)->SetChannelVolumes(values);
+}
+
+Napi::Value AudioSessionObject::StartMeter(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    uint32_t rate;
+    if (!parseMeterRate(info.Env(), info[0], &rate))
+        return Napi::Boolean::New(info.Env(), false);
+
+    if (!metering)
+    {
+        _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+        metering = session->StartMeter(rate);
+        if (metering)
+            Ref();
+    }
+
+    return Napi::Boolean::New(info.Env(), metering);
+}
+
+Napi::Value AudioSessionObject::StopMeter(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    bool stopped = metering;
+    if (metering)
+    {
+        ReleaseMeter();
+        Unref();
+    }
+
+    return Napi::Boolean::New(info.Env(), stopped);
+}
+
+Napi::Value AudioSessionObject::GetMeterBuffer(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()) || !metering)
+        return info.Env().Null();
+
+    if (ring == nullptr)
+    {
+        ring = reinterpret_cast<_AudioSession *>(pSession)->AttachMeterRing(
+            METER_RING_SLOTS);
+        if (ring == nullptr)
+            return info.Env().Null();
+        ringBuffer = Napi::Persistent(
+            ringToArrayBuffer(info.Env(), ring).As<Napi::Object>());
+    }
+
+    return ringBuffer.Value();
+}
+
+Napi::Value AudioSessionObject::StartLoudness(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    uint32_t intervalMs;
+    if (!parseLoudnessInterval(info.Env(), info[0], &intervalMs))
+        return Napi::Boolean::New(info.Env(), false);
+
+    if (!loudness)
+    {
+        _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+        loudness = session->StartLoudness(intervalMs);
+        if (loudness)
+            Ref();
+    }
+
+    return Napi::Boolean::New(info.Env(), loudness);
+}
+
+Napi::Value AudioSessionObject::StopLoudness(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    bool stopped = loudness;
+    if (loudness)
+    {
+        ReleaseLoudness();
+        Unref();
+    }
+
+    return Napi::Boolean::New(info.Env(), stopped);
+}
+
+Napi::Value AudioSessionObject::StartSilenceDetection(
+    const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    float threshold;
+    uint32_t holdMs;
+    if (!parseSilenceOptions(info.Env(), info[0], &threshold, &holdMs))
+        return Napi::Boolean::New(info.Env(), false);
+
+    if (!detecting)
+    {
+        _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+        detecting = session->StartSilenceDetector(threshold, holdMs);
+        if (detecting)
+            Ref();
+    }
+
+    return Napi::Boolean::New(info.Env(), detecting);
+}
+
+Napi::Value AudioSessionObject::StopSilenceDetection(
+    const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
+    bool stopped = detecting;
+    if (detecting)
+    {
+        ReleaseSilenceDetector();
+        Unref();
+    }
+
+    return Napi::Boolean::New(info.Env(), stopped);
+}
+
+Napi::Value AudioSessionObject::SetMaxVolume(const Napi::CallbackInfo &info)
+{
+    pa_volume_t max;
+    if (!EnsureAlive(info.Env())
+        || !parseMaxVolume(info.Env(), info[0], &max))
+        return Napi::Boolean::New(info.Env(), false);
+
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    return Napi::Boolean::New(info.Env(), session->SetMaxVolume(max));
+}
+
+Napi::Value AudioSessionObject::MoveTo(const Napi::CallbackInfo &info)
+{
+    Target device;
+    if (!EnsureAlive(info.Env())
+        || !parseDestination(info.Env(), info[0], &device))
+        return Napi::Boolean::New(info.Env(), false);
+
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    if (device.type != session->type())
+    {
+        Napi::Error::New(
+            info.Env(), "Expected a Device of the type of the session")
+            .ThrowAsJavaScriptException();
+        return Napi::Boolean::New(info.Env(), false);
+    }
+
+    return Napi::Boolean::New(info.Env(), session->MoveTo(device.index));
+}
+
+void AudioSessionObject::ReleaseSilenceDetector()
+{
+    if (!detecting)
+        return;
+
+    reinterpret_cast<_AudioSession *>(pSession)->StopSilenceDetector();
+    detecting = false;
+}
+
+void AudioSessionObject::ReleaseLoudness()
+{
+    if (!loudness)
+        return;
+
+    reinterpret_cast<_AudioSession *>(pSession)->StopLoudness();
+    loudness = false;
+}
+
+void AudioSessionObject::ReleaseMeter()
+{
+    if (!metering)
+        return;
+
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    if (ring != nullptr)
+        session->DetachMeterRing(ring);
+    ring.reset();
+    ringBuffer.Reset();
+    session->StopMeter();
+    metering = false;
+}
+
+Napi::Value AudioSessionObject::GetRawVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    pa_cvolume vol = session->GetRawVolume();
+    return Napi::Number::New(info.Env(), pa_cvolume_avg(&vol));
+}
+
+Napi::Value AudioSessionObject::GetRawChannels(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
+    _AudioSession *session = reinterpret_cast<_AudioSession *>(pSession);
+    return rawChannelsToArray(info.Env(), session->GetRawVolume());
+}
+
+Napi::Value AudioSessionObject::SetRawVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Undefined();
+
+    pa_cvolume values;
+    if (parseRawVolume(info.Env(), info[0], &values))
+        reinterpret_cast<_AudioSession *>(pSession)->SetRawVolume(values);
+
+    return info.Env().Undefined();
+}
+
+static void releaseFragment(Napi::Env, void *data)
+{
+    std::free(data);
+}
+
+void CallCapture(
+    Napi::Env env, Napi::Function cb, void *, CaptureFragment *fragment)
+{
+    if (env == nullptr || cb == nullptr)
+    {
+        if (fragment != nullptr)
+            std::free(fragment->data);
+        delete fragment;
+        return;
+    }
+    if (fragment == nullptr)
+        return;
+
+    // the buffer takes over the samples, freed when it is collected
+    Napi::Value value = env.Null();
+    if (fragment->data != NULL)
+        value = Napi::ArrayBuffer::New(
+            env, fragment->data, fragment->length, releaseFragment);
+    delete fragment;
+
+    cb.Call({value});
+}
+
+Napi::Object CaptureObject::Init(Napi::Env env, Napi::Object exports)
+{
+    Napi::Function func = DefineClass(env, "Capture",
+        {InstanceAccessor<&CaptureObject::GetFormat>("format"),
+            InstanceAccessor<&CaptureObject::GetRate>("rate"),
+            InstanceAccessor<&CaptureObject::GetChannels>("channels"),
+            InstanceMethod<&CaptureObject::Close>("close")});
+
+    constructor = new Napi::FunctionReference();
+    *constructor = Napi::Persistent(func);
+
+    return exports;
+}
+
+CaptureObject::CaptureObject(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<CaptureObject>(info)
+{
+}
+
+CaptureObject::~CaptureObject()
+{
+    CloseStream();
+}
+
+Napi::Value CaptureObject::New(Napi::Env env, _Device *device,
+    const pa_sample_spec &spec, uint32_t fragmentMs, Napi::Function callback)
+{
+    Napi::Object result = constructor->New({});
+    CaptureObject *obj = Napi::ObjectWrap<CaptureObject>::Unwrap(result);
+    obj->spec = spec;
+    obj->tsfn = CaptureTSFN::New(
+        env, callback, "sound-mixer-capture", CAPTURE_QUEUE_SIZE, 1, nullptr);
+    obj->capture = device->OpenCapture(spec, fragmentMs, OnData, obj);
+    if (obj->capture == NULL)
+    {
+        obj->tsfn.Release();
+        Napi::Error::New(env, "Could not open the capture stream")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // kept alive while open, the callback being its only user
+    obj->Ref();
+    return result;
+}
+
+void CaptureObject::OnData(void *userdata, const void *data, size_t length)
+{
+    CaptureObject *obj = reinterpret_cast<CaptureObject *>(userdata);
+    CaptureFragment *fragment = new CaptureFragment {NULL, 0};
+    if (data != NULL)
+    {
+        fragment->data = std::malloc(length);
+        std::memcpy(fragment->data, data, length);
+        fragment->length = length;
+    }
+
+    // dropped when JS does not keep up
+    if (obj->tsfn.NonBlockingCall(fragment) != napi_ok)
+    {
+        std::free(fragment->data);
+        delete fragment;
+    }
+}
+
+void CaptureObject::CloseStream()
+{
+    if (capture == NULL)
+        return;
+
+    capture->monitor->CloseCapture(capture);
+    capture = NULL;
+    tsfn.Release();
+}
+
+Napi::Value CaptureObject::Close(const Napi::CallbackInfo &info)
+{
+    if (capture != NULL)
+    {
+        CloseStream();
+        Unref();
+    }
+
+    return info.Env().Undefined();
+}
+
+Napi::Value CaptureObject::GetFormat(const Napi::CallbackInfo &info)
+{
+    for (auto &entry : captureFormats)
+    {
+        if (entry.format == spec.format)
+            return Napi::String::New(info.Env(), entry.name);
+    }
+
+    return info.Env().Undefined();
+}
+
+Napi::Value CaptureObject::GetRate(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), spec.rate);
+}
+
+Napi::Value CaptureObject::GetChannels(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), spec.channels);
+}
+
+Napi::Object VolumeGroupObject::Init(Napi::Env env, Napi::Object exports)
+{
+    Napi::Function func = DefineClass(env, "VolumeGroup",
+        {InstanceAccessor<&VolumeGroupObject::GetMode>("mode"),
+            InstanceAccessor<&VolumeGroupObject::GetVolume,
+                &VolumeGroupObject::SetVolume>("volume"),
+            InstanceAccessor<&VolumeGroupObject::GetMute,
+                &VolumeGroupObject::SetMute>("mute")});
+
+    constructor = new Napi::FunctionReference();
+    *constructor = Napi::Persistent(func);
+
+    return exports;
+}
+
+VolumeGroupObject::VolumeGroupObject(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<VolumeGroupObject>(info)
+{
+}
+
+VolumeGroupObject::~VolumeGroupObject()
+{
+}
+
+Napi::Value VolumeGroupObject::New(
+    Napi::Env env, const vector<Target> &members, bool relative)
+{
+    Napi::Object result = constructor->New({});
+    VolumeGroupObject *obj
+        = Napi::ObjectWrap<VolumeGroupObject>::Unwrap(result);
+    obj->members = members;
+    obj->relative = relative;
+    obj->shapes.assign(members.size(), pa_cvolume {});
+
+    return result;
+}
+
+Napi::Value VolumeGroupObject::GetMode(const Napi::CallbackInfo &info)
+{
+    return Napi::String::New(info.Env(), relative ? "relative" : "absolute");
+}
+
+Napi::Value VolumeGroupObject::GetVolume(const Napi::CallbackInfo &info)
+{
+    pa_volume_t loudest = PA_VOLUME_MUTED;
+    vector<VolumeState> states = MixerObject::mixer->GetVolumeStates(members);
+    for (const VolumeState &state : states)
+    {
+        if (state.found)
+            loudest = std::max(loudest, pa_cvolume_max(&state.volume));
+    }
+
+    return Napi::Number::New(info.Env(), VolumeToScalar(loudest));
+}
+
+void VolumeGroupObject::SetVolume(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    float v = value.As<Napi::Number>().FloatValue();
+    if (!ValidScalar(v))
+        return;
+
+    pa_volume_t volume = VolumeFromScalar(v);
+    vector<VolumeState> states = MixerObject::mixer->GetVolumeStates(members);
+    pa_volume_t loudest = PA_VOLUME_MUTED;
+    for (const VolumeState &state : states)
+    {
+        if (state.found)
+            loudest = std::max(loudest, pa_cvolume_max(&state.volume));
+    }
+
+    // absent members are skipped, having no channel
+    vector<pa_cvolume> volumes(states.size(), pa_cvolume {});
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        if (!states[i].found)
+            continue;
+
+        pa_cvolume &vol = volumes[i];
+        vol = states[i].volume;
+        pa_cvolume &shape = shapes[i];
+        if (relative && loudest > PA_VOLUME_MUTED)
+        {
+            shape = vol;
+            for (uint8_t c = 0; c < shape.channels; c++)
+                shape.values[c] = (pa_volume_t)((uint64_t)vol.values[c]
+                    * PA_VOLUME_NORM / loudest);
+        }
+
+        if (!relative || shape.channels != vol.channels)
+        {
+            pa_cvolume_set(&vol, vol.channels, volume);
+            continue;
+        }
+        for (uint8_t c = 0; c < vol.channels; c++)
+            vol.values[c] = (pa_volume_t)((uint64_t)shape.values[c] * volume
+                / PA_VOLUME_NORM);
+    }
+
+    MixerObject::mixer->SetVolumes(members, volumes);
+}
+
+Napi::Value VolumeGroupObject::GetMute(const Napi::CallbackInfo &info)
+{
+    bool mute = false;
+    vector<VolumeState> states = MixerObject::mixer->GetVolumeStates(members);
+    for (const VolumeState &state : states)
+    {
+        if (!state.found)
+            continue;
+        if (!state.mute)
+            return Napi::Boolean::New(info.Env(), false);
+        mute = true;
+    }
+
+    return Napi::Boolean::New(info.Env(), mute);
+}
+
+void VolumeGroupObject::SetMute(
+    const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    MixerObject::mixer->SetMutes(members, value.ToBoolean().Value());
+}
+
 } // namespace SoundMixer
@@ -1,15 +1,128 @@
 #pragma once
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <napi.h>
+#include <utility>
 #include <vector>
+#include "linux-sound-mixer.hpp"
 #include "sound-mixer-utils.hpp"
+#include "spectrum.hpp"
+#include "volume-scale.hpp"
 
 namespace SoundMixer
 {
 
 Napi::Object Init(Napi::Env, Napi::Object);
 
+/**
+ *  \brief      Weak cache of the JS wrappers handed out for server objects,
+ *  so that enumerating the same sink or stream again returns the wrapper
+ *  that is still alive instead of allocating a new one.
+ *
+ *  \remarks    Entries are keyed by (kind, type, index, generation). The
+ *  generation of an index is bumped when the server reports its removal, so
+ *  a reused index never resolves to a stale wrapper. Invalidate() may be
+ *  called from any thread, the other members only from the JS thread.
+ */
+class WrapperCache {
+  public:
+    typedef std::pair<uint64_t, uint32_t> Key;
+
+    Key KeyOf(SoundMixerUtils::Target target);
+    Napi::Object Find(const Key &key);
+    void Insert(const Key &key, Napi::Object wrapper, void *owner);
+    void Erase(const Key &key, void *owner);
+    void Invalidate(SoundMixerUtils::Target target);
+
+  private:
+    typedef struct
+    {
+        Napi::ObjectReference ref;
+        void *owner;
+    } Entry;
+
+    std::mutex m_mutex;
+    std::map<uint64_t, uint32_t> m_generations;
+    std::map<Key, Entry> m_wrappers;
+};
+
+typedef struct
+{
+    // samples allocated with malloc, NULL once the capture has ended
+    void *data;
+    size_t length;
+} CaptureFragment;
+
+void CallCapture(
+    Napi::Env env, Napi::Function cb, void *context, CaptureFragment *data);
+
+using CaptureTSFN
+    = Napi::TypedThreadSafeFunction<void, CaptureFragment, CallCapture>;
+
+/**
+ *  \brief      A recording stream opened by Device.openCapture(), handing
+ *  every fragment to a JS callback as an external ArrayBuffer.
+ */
+class CaptureObject : public Napi::ObjectWrap<CaptureObject> {
+  public:
+    static Napi::Object Init(Napi::Env, Napi::Object);
+    static Napi::Value New(Napi::Env, LinuxSoundMixer::_Device *device,
+        const pa_sample_spec &spec, uint32_t fragmentMs,
+        Napi::Function callback);
+    CaptureObject(const Napi::CallbackInfo &info);
+    virtual ~CaptureObject();
+
+    Napi::Value GetFormat(const Napi::CallbackInfo &info);
+    Napi::Value GetRate(const Napi::CallbackInfo &info);
+    Napi::Value GetChannels(const Napi::CallbackInfo &info);
+    Napi::Value Close(const Napi::CallbackInfo &info);
+
+  public:
+    static Napi::FunctionReference *constructor;
+
+  private:
+    // invoked on the mainloop thread of the EventMonitor
+    static void OnData(void *userdata, const void *data, size_t length);
+    void CloseStream();
+
+  private:
+    LinuxSoundMixer::_Capture *capture = NULL;
+    CaptureTSFN tsfn;
+    pa_sample_spec spec;
+};
+
+/**
+ *  \brief      Devices and sessions moved together, returned by
+ *  SoundMixer.createGroup(). Every member is read and written in a single
+ *  round trip.
+ */
+class VolumeGroupObject : public Napi::ObjectWrap<VolumeGroupObject> {
+  public:
+    static Napi::Object Init(Napi::Env, Napi::Object);
+    static Napi::Value New(Napi::Env,
+        const std::vector<SoundMixerUtils::Target> &members, bool relative);
+    VolumeGroupObject(const Napi::CallbackInfo &info);
+    virtual ~VolumeGroupObject();
+
+    Napi::Value GetMode(const Napi::CallbackInfo &info);
+    Napi::Value GetVolume(const Napi::CallbackInfo &info);
+    Napi::Value GetMute(const Napi::CallbackInfo &info);
+    void SetVolume(const Napi::CallbackInfo &info, const Napi::Value &value);
+    void SetMute(const Napi::CallbackInfo &info, const Napi::Value &value);
+
+  public:
+    static Napi::FunctionReference *constructor;
+
+  private:
+    std::vector<SoundMixerUtils::Target> members;
+    bool relative = false;
+    // in relative mode, the volume of every member when the loudest channel
+    // of the group is at PA_VOLUME_NORM, kept while the group is silent
+    std::vector<pa_cvolume> shapes;
+};
+
 class AudioSessionObject : public Napi::ObjectWrap<AudioSessionObject> {
   public:
     static Napi::Object Init(Napi::Env, Napi::Object);
@@ -17,20 +130,68 @@ class AudioSessionObject : public Napi::ObjectWrap<AudioSessionObject> {
     AudioSessionObject(const Napi::CallbackInfo &info);
     virtual ~AudioSessionObject();
 
+    Napi::Value GetName(const Napi::CallbackInfo &info);
+    Napi::Value GetAppName(const Napi::CallbackInfo &info);
+    Napi::Value GetState(const Napi::CallbackInfo &info);
     Napi::Value GetVolume(const Napi::CallbackInfo &info);
     Napi::Value GetMute(const Napi::CallbackInfo &info);
     void SetVolume(const Napi::CallbackInfo &info, const Napi::Value &value);
     void SetMute(const Napi::CallbackInfo &info, const Napi::Value &value);
+    Napi::Value StepVolume(const Napi::CallbackInfo &info);
 
     void SetChannelVolume(const Napi::CallbackInfo &info, const Napi::Value &);
     Napi::Value GetChannelVolume(const Napi::CallbackInfo &info);
 
+    void SetChannels(const Napi::CallbackInfo &info, const Napi::Value &);
+    Napi::Value GetChannels(const Napi::CallbackInfo &info);
+
+    Napi::Value GetRawVolume(const Napi::CallbackInfo &info);
+    Napi::Value GetRawChannels(const Napi::CallbackInfo &info);
+    Napi::Value SetRawVolume(const Napi::CallbackInfo &info);
+
+    Napi::Value StartMeter(const Napi::CallbackInfo &info);
+    Napi::Value StopMeter(const Napi::CallbackInfo &info);
+    Napi::Value GetMeterBuffer(const Napi::CallbackInfo &info);
+
+    Napi::Value StartLoudness(const Napi::CallbackInfo &info);
+    Napi::Value StopLoudness(const Napi::CallbackInfo &info);
+
+    Napi::Value StartSilenceDetection(const Napi::CallbackInfo &info);
+    Napi::Value StopSilenceDetection(const Napi::CallbackInfo &info);
+
+    Napi::Value SetMaxVolume(const Napi::CallbackInfo &info);
+    Napi::Value MoveTo(const Napi::CallbackInfo &info);
+
+    Napi::Value Dispose(const Napi::CallbackInfo &info);
+
+    /**
+     *  \return     false if the wrapper has been disposed.
+     */
+    bool GetTarget(SoundMixerUtils::Target *out);
+
   private:
     static Napi::Function GetClass(Napi::Env);
+    bool EnsureAlive(Napi::Env env);
+    void ReleaseMeter();
+    void ReleaseLoudness();
+    void ReleaseSilenceDetector();
+    void RefreshNames();
 
   public:
     void *pSession;
     static Napi::FunctionReference *constructor;
+
+  private:
+    std::string name;
+    std::string appName;
+    WrapperCache::Key key;
+    // whether this wrapper holds a reference on the meter of the session
+    bool metering = false;
+    std::shared_ptr<LinuxSoundMixer::SampleRing> ring;
+    Napi::ObjectReference ringBuffer;
+    // same for the loudness meter and the silence detector
+    bool loudness = false;
+    bool detecting = false;
 };
 
 class DeviceObject : public Napi::ObjectWrap<DeviceObject> {
@@ -47,17 +208,43 @@ class DeviceObject : public Napi::ObjectWrap<DeviceObject> {
     Napi::Value GetMute(const Napi::CallbackInfo &info);
     void SetVolume(const Napi::CallbackInfo &info, const Napi::Value &value);
     void SetMute(const Napi::CallbackInfo &info, const Napi::Value &value);
+    Napi::Value StepVolume(const Napi::CallbackInfo &info);
 
     Napi::Value RegisterEvent(const Napi::CallbackInfo &info);
     Napi::Value RemoveEvent(const Napi::CallbackInfo &info);
 
+    Napi::Value StartMeter(const Napi::CallbackInfo &info);
+    Napi::Value StopMeter(const Napi::CallbackInfo &info);
+    Napi::Value GetMeterBuffer(const Napi::CallbackInfo &info);
+    Napi::Value OpenCapture(const Napi::CallbackInfo &info);
+
+    Napi::Value StartSpectrum(const Napi::CallbackInfo &info);
+    Napi::Value StopSpectrum(const Napi::CallbackInfo &info);
+    Napi::Value GetSpectrumBuffer(const Napi::CallbackInfo &info);
+
+    Napi::Value StartLoudness(const Napi::CallbackInfo &info);
+    Napi::Value StopLoudness(const Napi::CallbackInfo &info);
+
+    Napi::Value SetMaxVolume(const Napi::CallbackInfo &info);
+    Napi::Value PlaySample(const Napi::CallbackInfo &info);
+
     void SetChannelVolume(
         const Napi::CallbackInfo &info, const Napi::Value &value);
     Napi::Value GetChannelVolume(const Napi::CallbackInfo &info);
 
+    void SetChannels(const Napi::CallbackInfo &info, const Napi::Value &);
+    Napi::Value GetChannels(const Napi::CallbackInfo &info);
+
+    Napi::Value GetRawVolume(const Napi::CallbackInfo &info);
+    Napi::Value GetRawChannels(const Napi::CallbackInfo &info);
+    Napi::Value SetRawVolume(const Napi::CallbackInfo &info);
+
     Napi::Value GetSessions(const Napi::CallbackInfo &info);
 
+    Napi::Value Dispose(const Napi::CallbackInfo &info);
+
     bool Update();
+    bool GetTarget(SoundMixerUtils::Target *out);
 
   public:
     static Napi::FunctionReference *constructor;
@@ -65,9 +252,30 @@ class DeviceObject : public Napi::ObjectWrap<DeviceObject> {
   private:
     Napi::Value GetName();
     static Napi::Function GetClass(Napi::Env);
+    bool EnsureAlive(Napi::Env env);
+    void ReleaseMeter();
+    void ReleaseSpectrum();
+    void ReleaseLoudness();
+    // invoked on the mainloop thread of the EventMonitor
+    static void OnSpectrumData(void *userdata, const void *data, size_t);
 
   private:
     void *pDevice;
+    std::string name;
+    int type;
+    WrapperCache::Key key;
+    // listeners registered through this wrapper, released on dispose
+    std::map<int, SoundMixerUtils::EventType> handlers;
+    // whether this wrapper holds a reference on the meter of the device
+    bool metering = false;
+    std::shared_ptr<LinuxSoundMixer::SampleRing> ring;
+    Napi::ObjectReference ringBuffer;
+    // the capture feeding the analyser, owned by this wrapper
+    LinuxSoundMixer::_Capture *spectrum = NULL;
+    std::unique_ptr<LinuxSoundMixer::SpectrumAnalyser> analyser;
+    Napi::ObjectReference spectrumBuffer;
+    // whether this wrapper holds a reference on the loudness meter
+    bool loudness = false;
     SoundMixerUtils::DeviceDescriptor Desc();
 };
 
@@ -75,15 +283,32 @@ class MixerObject : public Napi::ObjectWrap<MixerObject> {
   public:
     static Napi::Object Init(Napi::Env, Napi::Object);
     static Napi::Value GetDevices(const Napi::CallbackInfo &info);
+    static Napi::Value GetPoolStats(const Napi::CallbackInfo &info);
     MixerObject(const Napi::CallbackInfo &info);
     virtual ~MixerObject();
     static Napi::Value GetDefaultDevice(const Napi::CallbackInfo &info);
+    static Napi::Value SetDefaultDevice(const Napi::CallbackInfo &info);
+    static Napi::Value GetVolumeScale(const Napi::CallbackInfo &info);
+    static void SetVolumeScale(
+        const Napi::CallbackInfo &info, const Napi::Value &value);
+    static Napi::Value SetRules(const Napi::CallbackInfo &info);
+    static Napi::Value CreateGroup(const Napi::CallbackInfo &info);
+    static Napi::Value MoveSessions(const Napi::CallbackInfo &info);
+    static Napi::Value UploadSample(const Napi::CallbackInfo &info);
+    static Napi::Value RemoveSample(const Napi::CallbackInfo &info);
+    static Napi::Value StartDucking(const Napi::CallbackInfo &info);
+    static Napi::Value StopDucking(const Napi::CallbackInfo &info);
+    static Napi::Value RegisterEvent(const Napi::CallbackInfo &info);
+    static Napi::Value RemoveEvent(const Napi::CallbackInfo &info);
+    static Napi::Value ResolveTarget(Napi::Env, SoundMixerUtils::Target);
+    static void on_device_change_cb(SoundMixerUtils::DeviceDescriptor d,
+        SoundMixerUtils::NotificationHandler data);
+    static void on_session_change_cb(SoundMixerUtils::Subject s,
+        SoundMixerUtils::NotificationHandler data);
 
-    /*           static void
-       on_device_change_cb(SoundMixerUtils::DeviceDescriptor d,
-       SoundMixerUtils::NotificationHandler data);
-
-           public:
-               static SoundMixerUtils::EventPool *eventPool;*/
+  public:
+    static SoundMixerUtils::EventPool *eventPool;
+    static LinuxSoundMixer::SoundMixer *mixer;
+    static WrapperCache *wrappers;
 };
 } // namespace SoundMixer
@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "spectrum.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPECTRUM_X86
+#include <immintrin.h>
+#endif
+
+// lowest band edge in Hz, when the FFT is fine enough to resolve it
+#define LOWEST_FREQUENCY 20.
+
+namespace LinuxSoundMixer
+{
+
+/**
+ *  \brief      Windows `2 * count` interleaved samples into the real and
+ *  imaginary parts of the complex FFT input.
+ */
+static void _window_scalar(const float *samples, const float *even,
+    const float *odd, float *re, float *im, size_t count)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        re[n] = samples[2 * n] * even[n];
+        im[n] = samples[2 * n + 1] * odd[n];
+    }
+}
+
+static void _magnitude_scalar(
+    const float *re, const float *im, float scale, float *out, size_t count)
+{
+    for (size_t k = 0; k < count; k++)
+        out[k] = std::sqrt(re[k] * re[k] + im[k] * im[k]) * scale;
+}
+
+#ifdef SPECTRUM_X86
+
+__attribute__((target("sse2"))) static size_t _window_sse2(
+    const float *samples, const float *even, const float *odd, float *re,
+    float *im, size_t count)
+{
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 a = _mm_loadu_ps(samples + 2 * n);
+        __m128 b = _mm_loadu_ps(samples + 2 * n + 4);
+        __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 i = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(re + n, _mm_mul_ps(r, _mm_loadu_ps(even + n)));
+        _mm_storeu_ps(im + n, _mm_mul_ps(i, _mm_loadu_ps(odd + n)));
+    }
+
+    return n;
+}
+
+__attribute__((target("sse2"))) static size_t _magnitude_sse2(
+    const float *re, const float *im, float scale, float *out, size_t count)
+{
+    const __m128 factor = _mm_set1_ps(scale);
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4)
+    {
+        __m128 r = _mm_loadu_ps(re + k);
+        __m128 i = _mm_loadu_ps(im + k);
+        __m128 power = _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(i, i));
+        _mm_storeu_ps(out + k, _mm_mul_ps(_mm_sqrt_ps(power), factor));
+    }
+
+    return k;
+}
+
+/**
+ *  \brief      The 8 pairs wide version of _window_sse2, the in-lane
+ *  shuffles being put back in order across the two lanes.
+ */
+__attribute__((target("avx2"))) static size_t _window_avx2(
+    const float *samples, const float *even, const float *odd, float *re,
+    float *im, size_t count)
+{
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        __m256 a = _mm256_loadu_ps(samples + 2 * n);
+        __m256 b = _mm256_loadu_ps(samples + 2 * n + 8);
+        __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 i = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        r = _mm256_castpd_ps(_mm256_permute4x64_pd(
+            _mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+        i = _mm256_castpd_ps(_mm256_permute4x64_pd(
+            _mm256_castps_pd(i), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(re + n, _mm256_mul_ps(r, _mm256_loadu_ps(even + n)));
+        _mm256_storeu_ps(im + n, _mm256_mul_ps(i, _mm256_loadu_ps(odd + n)));
+    }
+
+    return n;
+}
+
+__attribute__((target("avx2"))) static size_t _magnitude_avx2(
+    const float *re, const float *im, float scale, float *out, size_t count)
+{
+    const __m256 factor = _mm256_set1_ps(scale);
+    size_t k = 0;
+    for (; k + 8 <= count; k += 8)
+    {
+        __m256 r = _mm256_loadu_ps(re + k);
+        __m256 i = _mm256_loadu_ps(im + k);
+        __m256 power
+            = _mm256_add_ps(_mm256_mul_ps(r, r), _mm256_mul_ps(i, i));
+        _mm256_storeu_ps(
+            out + k, _mm256_mul_ps(_mm256_sqrt_ps(power), factor));
+    }
+
+    return k;
+}
+
+#endif
+
+static void _window(const float *samples, const float *even, const float *odd,
+    float *re, float *im, size_t count, MeterKernel kernel)
+{
+    size_t done = 0;
+#ifdef SPECTRUM_X86
+    if (kernel == KERNEL_AVX2)
+        done = _window_avx2(samples, even, odd, re, im, count);
+    else if (kernel == KERNEL_SSE2)
+        done = _window_sse2(samples, even, odd, re, im, count);
+#endif
+    _window_scalar(samples + 2 * done, even + done, odd + done, re + done,
+        im + done, count - done);
+}
+
+static void _magnitude(const float *re, const float *im, float scale,
+    float *out, size_t count, MeterKernel kernel)
+{
+    size_t done = 0;
+#ifdef SPECTRUM_X86
+    if (kernel == KERNEL_AVX2)
+        done = _magnitude_avx2(re, im, scale, out, count);
+    else if (kernel == KERNEL_SSE2)
+        done = _magnitude_sse2(re, im, scale, out, count);
+#endif
+    _magnitude_scalar(
+        re + done, im + done, scale, out + done, count - done);
+}
+
+static double _window_value(SpectrumWindow window, uint32_t n, uint32_t size)
+{
+    double phase = 2 * M_PI * n / size;
+    switch (window)
+    {
+        case WINDOW_HANN:
+            return 0.5 - 0.5 * std::cos(phase);
+        case WINDOW_HAMMING:
+            return 0.54 - 0.46 * std::cos(phase);
+        case WINDOW_BLACKMAN:
+            return 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2 * phase);
+        default:
+            return 1.;
+    }
+}
+
+SpectrumAnalyser::SpectrumAnalyser(uint32_t size, uint32_t hop,
+    SpectrumWindow window, uint32_t bands, uint32_t rate, uint32_t slots,
+    MeterKernel kernel)
+    : size(size), hop(hop), half(size / 2), history(size),
+      windowEven(half), windowOdd(half), reversed(half),
+      twiddleRe(half), twiddleIm(half), splitCos(half + 1),
+      splitSin(half + 1), re(half), im(half), binRe(half + 1),
+      binIm(half + 1), magnitude(half + 1), bandLow(bands), bandHigh(bands),
+      levels(bands), ring(std::make_shared<SampleRing>(slots, bands))
+{
+    this->kernel = kernel == KERNEL_AUTO || kernel > BestMeterKernel()
+        ? BestMeterKernel()
+        : kernel;
+
+    double sum = 0;
+    for (uint32_t n = 0; n < half; n++)
+    {
+        windowEven[n] = (float)_window_value(window, 2 * n, size);
+        windowOdd[n] = (float)_window_value(window, 2 * n + 1, size);
+        sum += windowEven[n] + windowOdd[n];
+    }
+    // a sine centred on a bin reads its amplitude
+    scale = (float)(2 / sum);
+
+    uint32_t bits = 0;
+    while ((1U << bits) < half)
+        bits++;
+    for (uint32_t n = 0; n < half; n++)
+    {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < bits; b++)
+            r |= ((n >> b) & 1) << (bits - 1 - b);
+        reversed[n] = r;
+    }
+    // the stage of span 2 * middle reads its twiddles from middle - 1
+    for (uint32_t middle = 1; middle < half; middle <<= 1)
+    {
+        for (uint32_t j = 0; j < middle; j++)
+        {
+            double phase = -M_PI * j / middle;
+            twiddleRe[middle - 1 + j] = (float)std::cos(phase);
+            twiddleIm[middle - 1 + j] = (float)std::sin(phase);
+        }
+    }
+    for (uint32_t k = 0; k <= half; k++)
+    {
+        splitCos[k] = (float)std::cos(2 * M_PI * k / size);
+        splitSin[k] = (float)std::sin(2 * M_PI * k / size);
+    }
+
+    // log spaced edges, bands narrower than a bin sharing its value
+    double nyquist = rate / 2.;
+    double lowest = std::max(LOWEST_FREQUENCY, (double)rate / size);
+    if (lowest >= nyquist)
+        lowest = nyquist / 2;
+    for (uint32_t b = 0; b < bands; b++)
+    {
+        double from = lowest * std::pow(nyquist / lowest, (double)b / bands);
+        double to
+            = lowest * std::pow(nyquist / lowest, (double)(b + 1) / bands);
+        uint32_t low = (uint32_t)std::lround(from * size / rate);
+        uint32_t high = (uint32_t)std::lround(to * size / rate);
+        low = std::min(std::max(low, 1U), half);
+        bandLow[b] = low;
+        bandHigh[b] = std::min(std::max(high, low + 1), half + 1);
+    }
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+}
+
+std::shared_ptr<SampleRing> SpectrumAnalyser::Ring()
+{
+    return ring;
+}
+
+void SpectrumAnalyser::Feed(const float *samples, size_t count)
+{
+    while (count > 0)
+    {
+        size_t taken = std::min(count, (size_t)size - filled);
+        std::memcpy(history.data() + filled, samples, taken * sizeof(float));
+        filled += taken;
+        samples += taken;
+        count -= taken;
+
+        if (filled == size)
+        {
+            Analyse();
+            std::memmove(history.data(), history.data() + hop,
+                (size - hop) * sizeof(float));
+            filled = size - hop;
+        }
+    }
+}
+
+/**
+ *  \brief      In place radix-2 FFT of the `half` complex values in re and
+ *  im.
+ */
+void SpectrumAnalyser::Transform()
+{
+    for (uint32_t n = 0; n < half; n++)
+    {
+        uint32_t r = reversed[n];
+        if (r > n)
+        {
+            std::swap(re[n], re[r]);
+            std::swap(im[n], im[r]);
+        }
+    }
+
+    // contiguous twiddles keep the butterflies vectorisable
+    for (uint32_t middle = 1; middle < half; middle <<= 1)
+    {
+        const float *wr = twiddleRe.data() + middle - 1;
+        const float *wi = twiddleIm.data() + middle - 1;
+        for (uint32_t i = 0; i < half; i += 2 * middle)
+        {
+            float *__restrict__ r0 = re.data() + i;
+            float *__restrict__ i0 = im.data() + i;
+            float *__restrict__ r1 = r0 + middle;
+            float *__restrict__ i1 = i0 + middle;
+            for (uint32_t j = 0; j < middle; j++)
+            {
+                float tr = r1[j] * wr[j] - i1[j] * wi[j];
+                float ti = r1[j] * wi[j] + i1[j] * wr[j];
+                r1[j] = r0[j] - tr;
+                i1[j] = i0[j] - ti;
+                r0[j] += tr;
+                i0[j] += ti;
+            }
+        }
+    }
+}
+
+/**
+ *  \brief      Computes the spectrum of the history: the even and odd
+ *  samples go through one complex FFT of half the size, whose result is
+ *  then split into the bins of the real signal.
+ */
+void SpectrumAnalyser::Analyse()
+{
+    _window(history.data(), windowEven.data(), windowOdd.data(), re.data(),
+        im.data(), half, kernel);
+    Transform();
+
+    for (uint32_t k = 0; k <= half; k++)
+    {
+        uint32_t a = k % half;
+        uint32_t b = (half - k) % half;
+        // even and odd parts, with Z[half - k] conjugated
+        float evenRe = (re[a] + re[b]) / 2;
+        float evenIm = (im[a] - im[b]) / 2;
+        float oddRe = (im[a] + im[b]) / 2;
+        float oddIm = -(re[a] - re[b]) / 2;
+        float wr = splitCos[k];
+        float wi = -splitSin[k];
+        binRe[k] = evenRe + oddRe * wr - oddIm * wi;
+        binIm[k] = evenIm + oddRe * wi + oddIm * wr;
+    }
+    _magnitude(binRe.data(), binIm.data(), scale, magnitude.data(), half + 1,
+        kernel);
+
+    for (size_t b = 0; b < levels.size(); b++)
+    {
+        levels[b] = *std::max_element(
+            magnitude.begin() + bandLow[b], magnitude.begin() + bandHigh[b]);
+    }
+    ring->Push(levels.data());
+}
+
+} // namespace LinuxSoundMixer
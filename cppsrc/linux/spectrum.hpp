@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "meter-kernels.hpp"
+#include "sample-ring.hpp"
+
+namespace LinuxSoundMixer
+{
+
+enum SpectrumWindow
+{
+    WINDOW_RECT = 0,
+    WINDOW_HANN = 1,
+    WINDOW_HAMMING = 2,
+    WINDOW_BLACKMAN = 3
+};
+
+/**
+ *  \brief      Short time spectrum of a mono float stream, reduced to
+ *  logarithmically spaced bands and published into a SampleRing, one slot
+ *  of `bands` floats per frame.
+ *
+ *  \remarks    A band holds the largest amplitude of its bins, a full scale
+ *  sine reading about 1. Feed() must only be called from one thread at a
+ *  time.
+ */
+class SpectrumAnalyser {
+  public:
+    /**
+     *  \param      size    The FFT size, a power of two of at least 4.
+     *  \param      hop     The samples between two frames, from 1 to size.
+     *  \param      bands   The number of bands, from 1 to size / 2.
+     *  \param      rate    The sample rate of the stream in Hz.
+     *  \param      slots   The number of frames kept in the ring.
+     */
+    SpectrumAnalyser(uint32_t size, uint32_t hop, SpectrumWindow window,
+        uint32_t bands, uint32_t rate, uint32_t slots,
+        MeterKernel kernel = KERNEL_AUTO);
+    virtual ~SpectrumAnalyser();
+
+    void Feed(const float *samples, size_t count);
+    std::shared_ptr<SampleRing> Ring();
+
+  private:
+    SpectrumAnalyser(const SpectrumAnalyser &);
+    SpectrumAnalyser &operator=(const SpectrumAnalyser &);
+
+    void Analyse();
+    void Transform();
+
+  private:
+    uint32_t size;
+    uint32_t hop;
+    // size / 2, the length of the complex FFT
+    uint32_t half;
+    MeterKernel kernel;
+    float scale;
+
+    std::vector<float> history;
+    size_t filled = 0;
+
+    // the window split between even and odd samples
+    std::vector<float> windowEven;
+    std::vector<float> windowOdd;
+    std::vector<uint32_t> reversed;
+    std::vector<float> twiddleRe;
+    std::vector<float> twiddleIm;
+    std::vector<float> splitCos;
+    std::vector<float> splitSin;
+
+    std::vector<float> re;
+    std::vector<float> im;
+    std::vector<float> binRe;
+    std::vector<float> binIm;
+    std::vector<float> magnitude;
+
+    // first and last bins of every band
+    std::vector<uint32_t> bandLow;
+    std::vector<uint32_t> bandHigh;
+    std::vector<float> levels;
+
+    std::shared_ptr<SampleRing> ring;
+};
+
+} // namespace LinuxSoundMixer
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include "volume-scale.hpp"
+
+// number of intervals of the conversion tables
+#define SCALE_STEPS 1024
+// lowest attenuation covered by the dB table, quieter values are computed
+#define SCALE_DB_RANGE 120.
+
+namespace LinuxSoundMixer
+{
+
+static std::atomic<int> currentScale(VolumeScale::LINEAR);
+
+/**
+ *  \brief      Conversion tables, sampled uniformly over their input range and
+ *  read with linear interpolation.
+ *
+ *  \remarks    The first interval of the tables starting at a silent volume
+ *  is computed exactly instead, the curves being too steep there.
+ */
+typedef struct
+{
+    // pa_volume_t in [0, PA_VOLUME_NORM] -> dB
+    float toDecibel[SCALE_STEPS + 1];
+    // dB in [-SCALE_DB_RANGE, 0] -> pa_volume_t
+    float fromDecibel[SCALE_STEPS + 1];
+    // amplitude in [0, 1] -> pa_volume_t
+    float fromCubic[SCALE_STEPS + 1];
+} _ScaleTables;
+
+static _ScaleTables _build_tables()
+{
+    _ScaleTables tables;
+    for (int i = 0; i <= SCALE_STEPS; i++)
+    {
+        double at = (double)i / SCALE_STEPS;
+        tables.toDecibel[i]
+            = pa_sw_volume_to_dB((pa_volume_t)(at * PA_VOLUME_NORM));
+        tables.fromDecibel[i]
+            = pa_sw_volume_from_dB((at - 1.) * SCALE_DB_RANGE);
+        tables.fromCubic[i] = pa_sw_volume_from_linear(at);
+    }
+
+    return tables;
+}
+
+static const _ScaleTables &_tables()
+{
+    static const _ScaleTables tables = _build_tables();
+    return tables;
+}
+
+static float _lookup(const float *table, double at)
+{
+    double position = at * SCALE_STEPS;
+    int i = std::min((int)position, SCALE_STEPS - 1);
+    float frac = (float)(position - i);
+
+    return table[i] + (table[i + 1] - table[i]) * frac;
+}
+
+void SetVolumeScale(VolumeScale scale)
+{
+    currentScale = scale;
+}
+
+VolumeScale GetVolumeScale()
+{
+    return (VolumeScale)currentScale.load();
+}
+
+float VolumeToScalar(pa_volume_t volume)
+{
+    volume = std::min(volume, (pa_volume_t)PA_VOLUME_NORM);
+    float linear = (float)volume / PA_VOLUME_NORM;
+    switch (GetVolumeScale())
+    {
+        case VolumeScale::CUBIC:
+            return linear * linear * linear;
+        case VolumeScale::DECIBEL:
+            if (volume < PA_VOLUME_NORM / SCALE_STEPS)
+                return pa_sw_volume_to_dB(volume);
+            return _lookup(_tables().toDecibel, linear);
+        default:
+            return linear;
+    }
+}
+
+pa_volume_t VolumeFromScalar(float scalar)
+{
+    float volume;
+    switch (GetVolumeScale())
+    {
+        case VolumeScale::CUBIC:
+            scalar = std::min(std::max(scalar, 0.F), 1.F);
+            if (scalar < 1.F / SCALE_STEPS)
+                return pa_sw_volume_from_linear(scalar);
+            volume = _lookup(_tables().fromCubic, scalar);
+            break;
+        case VolumeScale::DECIBEL:
+            scalar = std::min(scalar, 0.F);
+            if (scalar < -SCALE_DB_RANGE)
+                return pa_sw_volume_from_dB(scalar);
+            volume = _lookup(
+                _tables().fromDecibel, 1. + scalar / SCALE_DB_RANGE);
+            break;
+        default:
+            scalar = std::min(std::max(scalar, 0.F), 1.F);
+            volume = scalar * PA_VOLUME_NORM;
+            break;
+    }
+
+    return (pa_volume_t)std::lround(volume);
+}
+
+bool ValidScalar(float scalar)
+{
+    if (GetVolumeScale() == VolumeScale::DECIBEL)
+        return scalar <= 0.F;
+    return scalar >= 0.F && scalar <= 1.F;
+}
+
+} // namespace LinuxSoundMixer
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <pulse/pulseaudio.h>
+
+namespace LinuxSoundMixer
+{
+
+/**
+ *  \brief      The scale of the volumes exchanged with JS.
+ *
+ *  LINEAR is the raw pa_volume_t divided by PA_VOLUME_NORM, that is the
+ *  percentage shown by pavucontrol. CUBIC is the amplitude factor, the cube
+ *  of the LINEAR value. DECIBEL is the attenuation in dB, -Infinity when
+ *  silent.
+ */
+enum VolumeScale
+{
+    LINEAR = 0,
+    CUBIC = 1,
+    DECIBEL = 2
+};
+
+/**
+ *  \brief      Sets the scale used by every conversion. Thread safe.
+ */
+void SetVolumeScale(VolumeScale scale);
+VolumeScale GetVolumeScale();
+
+/**
+ *  \brief      Converts a volume to a scalar in the current scale.
+ */
+float VolumeToScalar(pa_volume_t volume);
+
+/**
+ *  \brief      Converts a scalar in the current scale to a volume, clamped to
+ *  [PA_VOLUME_MUTED, PA_VOLUME_NORM].
+ */
+pa_volume_t VolumeFromScalar(float scalar);
+
+/**
+ *  \brief      Whether scalar lies in the range of the current scale.
+ */
+bool ValidScalar(float scalar);
+
+} // namespace LinuxSoundMixer
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "sound-mixer.hpp"
 #include "win-sound-mixer.hpp"
 
@@ -18,37 +19,22 @@ void MixerObject::on_device_change_cb(
 {
     if (data.flags & DEVICE_CHANGE_MASK_MUTE)
     {
-        vector<TSFN> listeners
-            = eventPool->GetListeners(desc, EventType::MUTE);
-        for (TSFN cb : listeners)
-        {
-            NotificationHandler *pData = new NotificationHandler();
-            *pData = data;
-            pData->flags = DEVICE_CHANGE_MASK_MUTE;
-            cb.Acquire();
-            cb.NonBlockingCall(pData);
-            cb.Release();
-        }
+        NotificationHandler payload = data;
+        payload.flags = DEVICE_CHANGE_MASK_MUTE;
+        eventPool->Dispatch(desc, EventType::MUTE, payload);
     }
 
     if (data.flags & DEVICE_CHANGE_MASK_VOLUME)
     {
-        vector<TSFN> listeners
-            = eventPool->GetListeners(desc, EventType::VOLUME);
-        for (TSFN cb : listeners)
-        {
-            NotificationHandler *pData = new NotificationHandler();
-            *pData = data;
-            cb.Acquire();
-            pData->flags = DEVICE_CHANGE_MASK_VOLUME;
-            cb.BlockingCall(pData);
-            cb.Release();
-        }
+        NotificationHandler payload = data;
+        payload.flags = DEVICE_CHANGE_MASK_VOLUME;
+        eventPool->Dispatch(desc, EventType::VOLUME, payload);
     }
 }
 
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
+    InitPropertyKeys(env);
     MixerObject::Init(env, exports);
     DeviceObject::Init(env, exports);
     AudioSessionObject::Init(env, exports);
@@ -63,6 +49,7 @@ Napi::Object MixerObject::Init(Napi::Env env, Napi::Object exports)
     Napi::Function sm = DefineClass(env, "SoundMixer",
         {
             StaticAccessor<&MixerObject::GetDevices>("devices"),
+            StaticAccessor<&MixerObject::GetPoolStats>("poolStats"),
             StaticMethod<&MixerObject::GetDefaultDevice>("getDefaultDevice"),
         });
 
@@ -100,6 +87,18 @@ Napi::Value MixerObject::GetDevices(const Napi::CallbackInfo &info)
     return result;
 }
 
+Napi::Value MixerObject::GetPoolStats(const Napi::CallbackInfo &info)
+{
+    NotificationPoolStats stats = notificationPool.Stats();
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
+    Napi::Object result = Napi::Object::New(info.Env());
+    result.Set(keys->hits.Value(),
+        Napi::Number::New(info.Env(), (double)stats.hits));
+    result.Set(keys->misses.Value(),
+        Napi::Number::New(info.Env(), (double)stats.misses));
+    return result;
+}
+
 Napi::Object DeviceObject::Init(Napi::Env env, Napi::Object exports)
 {
     constructor = new Napi::FunctionReference();
@@ -122,7 +121,10 @@ Napi::Function DeviceObject::GetClass(Napi::Env env)
             InstanceAccessor<&DeviceObject::GetChannelVolume,
                 &DeviceObject::SetChannelVolume>("balance"),
             InstanceMethod<&DeviceObject::RegisterEvent>("on"),
-            InstanceMethod<&DeviceObject::RemoveEvent>("removeListener")});
+            InstanceMethod<&DeviceObject::RemoveEvent>("removeListener"),
+            InstanceMethod<&DeviceObject::StepVolume>("stepVolume"),
+            InstanceMethod<&DeviceObject::Dispose>("dispose")});
+    AliasDisposeSymbol(func);
 
     return func;
 }
@@ -160,19 +162,48 @@ DeviceObject::~DeviceObject()
 {
 }
 
+bool DeviceObject::EnsureAlive(Napi::Env env)
+{
+    if (!disposed)
+        return true;
+
+    Napi::Error::New(env, "This Device has been disposed")
+        .ThrowAsJavaScriptException();
+    return false;
+}
+
+Napi::Value DeviceObject::Dispose(const Napi::CallbackInfo &info)
+{
+    if (disposed)
+        return info.Env().Undefined();
+
+    DeviceDescriptor desc = Desc();
+    for (auto &handler : handlers)
+        MixerObject::eventPool->RemoveEvent(
+            desc, handler.second, handler.first);
+    handlers.clear();
+
+    // the Device itself is owned by the mixer
+    pDevice = NULL;
+    disposed = true;
+
+    return info.Env().Undefined();
+}
+
 Napi::Value DeviceObject::New(Napi::Env env, void *device)
 {
 
     Device *dev = reinterpret_cast<Device *>(device);
     Napi::Object result = constructor->New({});
     Napi::ObjectWrap<DeviceObject>::Unwrap(result)->pDevice = dev;
-    result.Set("name", dev->Desc().fullName);
-    result.Set("type", (int)dev->Desc().type);
     return result;
 }
 
 Napi::Value DeviceObject::GetName(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::String::New(info.Env(), "");
+
     if (!Update())
     {
         Napi::Error::New(info.Env(), "This Device is no longer available")
@@ -185,6 +216,9 @@ Napi::Value DeviceObject::GetName(const Napi::CallbackInfo &info)
 
 Napi::Value DeviceObject::GetType(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
     if (!Update())
     {
         Napi::Error::New(info.Env(), "This Device is no longer available")
@@ -197,6 +231,9 @@ Napi::Value DeviceObject::GetType(const Napi::CallbackInfo &info)
 
 Napi::Value DeviceObject::GetVolume(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
     Device *dev = reinterpret_cast<Device *>(pDevice);
     return Napi::Number::New(info.Env(), dev->GetVolume());
 }
@@ -204,13 +241,38 @@ Napi::Value DeviceObject::GetVolume(const Napi::CallbackInfo &info)
 void DeviceObject::SetVolume(
     const Napi::CallbackInfo &info, const Napi::Value &value)
 {
+    if (!EnsureAlive(info.Env()))
+        return;
+
     float volume = value.As<Napi::Number>().FloatValue();
     Device *dev = reinterpret_cast<Device *>(pDevice);
     dev->SetVolume(volume);
 }
 
+Napi::Value DeviceObject::StepVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsNumber())
+    {
+        Napi::Error::New(env, "Expected <delta>").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+
+    float delta = info[0].As<Napi::Number>().FloatValue();
+    Device *dev = reinterpret_cast<Device *>(pDevice);
+    float volume = std::min(std::max(dev->GetVolume() + delta, 0.F), 1.F);
+    dev->SetVolume(volume);
+    return Napi::Number::New(env, volume);
+}
+
 Napi::Value DeviceObject::GetMute(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
     Device *dev = reinterpret_cast<Device *>(pDevice);
     return Napi::Boolean::New(info.Env(), dev->GetMute());
 }
@@ -218,6 +280,9 @@ Napi::Value DeviceObject::GetMute(const Napi::CallbackInfo &info)
 void DeviceObject::SetMute(
     const Napi::CallbackInfo &info, const Napi::Value &value)
 {
+    if (!EnsureAlive(info.Env()))
+        return;
+
     bool val = value.As<Napi::Boolean>().Value();
     Device *dev = reinterpret_cast<Device *>(pDevice);
     dev->SetMute(val);
@@ -225,10 +290,14 @@ void DeviceObject::SetMute(
 
 Napi::Value DeviceObject::RegisterEvent(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
     Napi::Env env = info.Env();
-    if (info.Length() != 2 || !info[0].IsString() || !info[1].IsFunction())
+    if (info.Length() < 2 || info.Length() > 3 || !info[0].IsString()
+        || !info[1].IsFunction())
     {
-        Napi::Error::New(env, "Expected <event-type> <function>")
+        Napi::Error::New(env, "Expected <event-type> <function> [options]")
             .ThrowAsJavaScriptException();
         return Napi::Number::New(env, -1);
     }
@@ -242,17 +311,25 @@ Napi::Value DeviceObject::RegisterEvent(const Napi::CallbackInfo &info)
     else
         return Napi::Number::New(env, -1);
 
+    ListenerOptions options;
+    if (!ParseListenerOptions(env, info[2], &options))
+        return Napi::Number::New(env, -1);
+
     Napi::Function func = info[1].As<Napi::Function>();
     TSFN ref = TSFN::New(env, func, "test", 0, 1,
         new Napi::Reference<Napi::Value>(Napi::Persistent(info.This())));
 
-    int handler
-        = MixerObject::eventPool->RegisterEvent(Desc(), eventType, ref);
+    int handler = MixerObject::eventPool->RegisterEvent(
+        Desc(), eventType, ref, options);
+    handlers[handler] = eventType;
     return Napi::Number::New(env, handler);
 }
 
 Napi::Value DeviceObject::RemoveEvent(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
     Napi::Env env = info.Env();
     // expects EventType and event id
     if (info.Length() != 2 || !info[0].IsString() || !info[1].IsNumber())
@@ -271,39 +348,53 @@ Napi::Value DeviceObject::RemoveEvent(const Napi::CallbackInfo &info)
         return Napi::Number::New(env, -1);
     int handler = info[1].As<Napi::Number>().Int32Value();
     bool res = MixerObject::eventPool->RemoveEvent(Desc(), eventType, handler);
+    if (res)
+        handlers.erase(handler);
 
     return Napi::Boolean::New(env, res);
 }
 
 Napi::Value DeviceObject::GetChannelVolume(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
     Device *dev = reinterpret_cast<Device *>(pDevice);
     VolumeBalance balance = dev->GetVolumeBalance();
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
     Napi::Object result = Napi::Object::New(info.Env());
-    result.Set("right", balance.right);
-    result.Set("left", balance.left);
-    result.Set("stereo", balance.stereo);
+    result.Set(keys->right.Value(), balance.right);
+    result.Set(keys->left.Value(), balance.left);
+    result.Set(keys->stereo.Value(), balance.stereo);
     return result;
 }
 
 void DeviceObject::SetChannelVolume(
     const Napi::CallbackInfo &info, const Napi::Value &value)
 {
+    if (!EnsureAlive(info.Env()))
+        return;
+
     Napi::Object param = value.As<Napi::Object>();
-    if (!param.Has("right") || !param.Has("left"))
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
+    if (!param.Has(keys->right.Value()) || !param.Has(keys->left.Value()))
     {
         return;
     }
     Device *dev = reinterpret_cast<Device *>(pDevice);
     VolumeBalance balance
-        = {param.Get("right").As<Napi::Number>().FloatValue(),
-            param.Get("left").As<Napi::Number>().FloatValue(), true};
+        = {param.Get(keys->right.Value()).As<Napi::Number>().FloatValue(),
+            param.Get(keys->left.Value()).As<Napi::Number>().FloatValue(),
+            true};
 
     dev->SetVolumeBalance(balance);
 }
 
 Napi::Value DeviceObject::GetSessions(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Array::New(info.Env());
+
     Device *dev = reinterpret_cast<Device *>(pDevice);
     Napi::Array result = Napi::Array::New(info.Env());
     int i = 0;
@@ -322,14 +413,21 @@ AudioSessionObject::AudioSessionObject(const Napi::CallbackInfo &info)
 
 Napi::Function AudioSessionObject::GetClass(Napi::Env env)
 {
-    return DefineClass(env, "AudioSession",
+    Napi::Function func = DefineClass(env, "AudioSession",
         {InstanceAccessor<&AudioSessionObject::GetMute,
              &AudioSessionObject::SetMute>("mute"),
             InstanceAccessor<&AudioSessionObject::GetVolume,
                 &AudioSessionObject::SetVolume>("volume"),
             InstanceAccessor<&AudioSessionObject::GetChannelVolume,
                 &AudioSessionObject::SetChannelVolume>("balance"),
-            InstanceAccessor<&AudioSessionObject::GetState>("state")});
+            InstanceAccessor<&AudioSessionObject::GetState>("state"),
+            InstanceAccessor<&AudioSessionObject::GetName>("name"),
+            InstanceAccessor<&AudioSessionObject::GetAppName>("appName"),
+            InstanceMethod<&AudioSessionObject::StepVolume>("stepVolume"),
+            InstanceMethod<&AudioSessionObject::Dispose>("dispose")});
+    AliasDisposeSymbol(func);
+
+    return func;
 }
 
 Napi::Object AudioSessionObject::Init(Napi::Env env, Napi::Object exports)
@@ -344,19 +442,58 @@ AudioSessionObject::~AudioSessionObject()
     delete reinterpret_cast<AudioSession *>(pSession);
 }
 
+bool AudioSessionObject::EnsureAlive(Napi::Env env)
+{
+    if (pSession != NULL)
+        return true;
+
+    Napi::Error::New(env, "This AudioSession has been disposed")
+        .ThrowAsJavaScriptException();
+    return false;
+}
+
+Napi::Value AudioSessionObject::Dispose(const Napi::CallbackInfo &info)
+{
+    delete reinterpret_cast<AudioSession *>(pSession);
+    pSession = NULL;
+
+    return info.Env().Undefined();
+}
+
 Napi::Value AudioSessionObject::New(Napi::Env env, void *data)
 {
     AudioSession *session = reinterpret_cast<AudioSession *>(data);
     Napi::Object result = constructor->New({});
-    Napi::ObjectWrap<AudioSessionObject>::Unwrap(result)->pSession = session;
-    result.Set("name", session->name());
-    result.Set("appName", session->path());
+    AudioSessionObject *obj
+        = Napi::ObjectWrap<AudioSessionObject>::Unwrap(result);
+    obj->pSession = session;
+    obj->name = session->name();
+    obj->appName = session->path();
 
     return result;
 }
 
+Napi::Value AudioSessionObject::GetName(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::String::New(info.Env(), "");
+
+    return Napi::String::New(info.Env(), name);
+}
+
+Napi::Value AudioSessionObject::GetAppName(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::String::New(info.Env(), "");
+
+    return Napi::String::New(info.Env(), appName);
+}
+
 Napi::Value AudioSessionObject::GetVolume(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
     return Napi::Number::New(
         info.Env(), reinterpret_cast<AudioSession *>(pSession)->GetVolume());
 }
@@ -364,18 +501,47 @@ Napi::Value AudioSessionObject::GetVolume(const Napi::CallbackInfo &info)
 void AudioSessionObject::SetVolume(
     const Napi::CallbackInfo &info, const Napi::Value &value)
 {
+    if (!EnsureAlive(info.Env()))
+        return;
+
     float volume = value.As<Napi::Number>().FloatValue();
     reinterpret_cast<AudioSession *>(pSession)->SetVolume(volume);
 }
 
+Napi::Value AudioSessionObject::StepVolume(const Napi::CallbackInfo &info)
+{
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsNumber())
+    {
+        Napi::Error::New(env, "Expected <delta>").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+
+    float delta = info[0].As<Napi::Number>().FloatValue();
+    AudioSession *session = reinterpret_cast<AudioSession *>(pSession);
+    float volume
+        = std::min(std::max(session->GetVolume() + delta, 0.F), 1.F);
+    session->SetVolume(volume);
+    return Napi::Number::New(env, volume);
+}
+
 Napi::Value AudioSessionObject::GetMute(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Boolean::New(info.Env(), false);
+
     return Napi::Boolean::New(
         info.Env(), reinterpret_cast<AudioSession *>(pSession)->GetMute());
 }
 
 Napi::Value AudioSessionObject::GetState(const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return Napi::Number::New(info.Env(), -1);
+
     return Napi::Number::New(info.Env(),
         static_cast<int>(reinterpret_cast<AudioSession *>(pSession)->state()));
 }
@@ -383,6 +549,9 @@ Napi::Value AudioSessionObject::GetState(const Napi::CallbackInfo &info)
 void AudioSessionObject::SetMute(
     const Napi::CallbackInfo &info, const Napi::Value &value)
 {
+    if (!EnsureAlive(info.Env()))
+        return;
+
     bool val = value.As<Napi::Boolean>().Value();
     reinterpret_cast<AudioSession *>(pSession)->SetMute(val);
 }
@@ -390,26 +559,35 @@ void AudioSessionObject::SetMute(
 Napi::Value AudioSessionObject::GetChannelVolume(
     const Napi::CallbackInfo &info)
 {
+    if (!EnsureAlive(info.Env()))
+        return info.Env().Null();
+
     AudioSession *session = reinterpret_cast<AudioSession *>(pSession);
     VolumeBalance balance = session->GetVolumeBalance();
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
     Napi::Object result = Napi::Object::New(info.Env());
-    result.Set("right", balance.right);
-    result.Set("left", balance.left);
+    result.Set(keys->right.Value(), balance.right);
+    result.Set(keys->left.Value(), balance.left);
     return result;
 }
 
 void AudioSessionObject::SetChannelVolume(
     const Napi::CallbackInfo &info, const Napi::Value &value)
 {
+    if (!EnsureAlive(info.Env()))
+        return;
+
     Napi::Object param = value.As<Napi::Object>();
-    if (!param.Has("right") || !param.Has("left"))
+    PropertyKeys *keys = GetPropertyKeys(info.Env());
+    if (!param.Has(keys->right.Value()) || !param.Has(keys->left.Value()))
     {
         return;
     }
     AudioSession *session = reinterpret_cast<AudioSession *>(pSession);
     VolumeBalance balance
-        = {param.Get("right").As<Napi::Number>().FloatValue(),
-            param.Get("left").As<Napi::Number>().FloatValue(), true};
+        = {param.Get(keys->right.Value()).As<Napi::Number>().FloatValue(),
+            param.Get(keys->left.Value()).As<Napi::Number>().FloatValue(),
+            true};
 
     session->SetVolumeBalance(balance);
 }
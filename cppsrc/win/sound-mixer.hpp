@@ -18,21 +18,31 @@ class AudioSessionObject : public Napi::ObjectWrap<AudioSessionObject> {
     AudioSessionObject(const Napi::CallbackInfo &info);
     virtual ~AudioSessionObject();
 
+    Napi::Value GetName(const Napi::CallbackInfo &info);
+    Napi::Value GetAppName(const Napi::CallbackInfo &info);
     Napi::Value GetState(const Napi::CallbackInfo &info);
     Napi::Value GetVolume(const Napi::CallbackInfo &info);
     Napi::Value GetMute(const Napi::CallbackInfo &info);
     void SetVolume(const Napi::CallbackInfo &info, const Napi::Value &value);
     void SetMute(const Napi::CallbackInfo &info, const Napi::Value &value);
+    Napi::Value StepVolume(const Napi::CallbackInfo &info);
 
     void SetChannelVolume(const Napi::CallbackInfo &info, const Napi::Value &);
     Napi::Value GetChannelVolume(const Napi::CallbackInfo &info);
 
+    Napi::Value Dispose(const Napi::CallbackInfo &info);
+
   private:
     static Napi::Function GetClass(Napi::Env);
+    bool EnsureAlive(Napi::Env env);
 
   public:
     void *pSession;
     static Napi::FunctionReference *constructor;
+
+  private:
+    std::string name;
+    std::string appName;
 };
 
 class DeviceObject : public Napi::ObjectWrap<DeviceObject> {
@@ -49,6 +59,7 @@ class DeviceObject : public Napi::ObjectWrap<DeviceObject> {
     Napi::Value GetMute(const Napi::CallbackInfo &info);
     void SetVolume(const Napi::CallbackInfo &info, const Napi::Value &value);
     void SetMute(const Napi::CallbackInfo &info, const Napi::Value &value);
+    Napi::Value StepVolume(const Napi::CallbackInfo &info);
 
     Napi::Value RegisterEvent(const Napi::CallbackInfo &info);
     Napi::Value RemoveEvent(const Napi::CallbackInfo &info);
@@ -59,6 +70,8 @@ class DeviceObject : public Napi::ObjectWrap<DeviceObject> {
 
     Napi::Value GetSessions(const Napi::CallbackInfo &info);
 
+    Napi::Value Dispose(const Napi::CallbackInfo &info);
+
     bool Update();
 
   public:
@@ -67,9 +80,13 @@ class DeviceObject : public Napi::ObjectWrap<DeviceObject> {
   private:
     Napi::Value GetName();
     static Napi::Function GetClass(Napi::Env);
+    bool EnsureAlive(Napi::Env env);
 
   private:
     void *pDevice;
+    bool disposed = false;
+    // listeners registered through this wrapper, released on dispose
+    std::map<int, SoundMixerUtils::EventType> handlers;
     SoundMixerUtils::DeviceDescriptor Desc();
 };
 
@@ -77,6 +94,7 @@ class MixerObject : public Napi::ObjectWrap<MixerObject> {
   public:
     static Napi::Object Init(Napi::Env, Napi::Object);
     static Napi::Value GetDevices(const Napi::CallbackInfo &info);
+    static Napi::Value GetPoolStats(const Napi::CallbackInfo &info);
     MixerObject(const Napi::CallbackInfo &info);
     virtual ~MixerObject();
     static Napi::Value GetDefaultDevice(const Napi::CallbackInfo &info);
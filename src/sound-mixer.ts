@@ -53,6 +53,389 @@ export interface VolumeBalance {
 	stereo?: boolean;
 }
 
+/**
+ *  The volume of every channel of a {@link Device} or an
+ *  {@link AudioSession}.
+ */
+export interface ChannelVolumes {
+    /**
+     *  positions: The position of each channel, as a PulseAudio
+     *  `pa_channel_position_t` value.
+     */
+	positions: Uint8Array;
+
+    /**
+     *  volumes: The volume of each channel.
+     */
+	volumes: Float32Array;
+}
+
+/**
+ *  Counters of the native pool notification payloads are taken from,
+ *  read through {@link SoundMixer.poolStats}.
+ */
+export interface PoolStats {
+    /**
+     *  hits: The payloads taken from the pool.
+     */
+	hits: number;
+
+    /**
+     *  misses: The payloads allocated on the heap because the pool was
+     *  exhausted.
+     */
+	misses: number;
+}
+
+/**
+ *  Options given to {@link Device.on} to limit how often a listener is
+ *  called. Excess events are dropped natively, before reaching JS.
+ */
+export interface ListenerOptions {
+    /**
+     *  maxRate: The maximum number of calls per second, which may be
+     *  fractional.
+     */
+	maxRate?: number;
+
+    /**
+     *  debounceMs: Delays the call until no event was triggered for the
+     *  given amount of milliseconds.
+     */
+	debounceMs?: number;
+
+    /**
+     *  leading: Calls the listener on the first event of a burst.
+     *  Defaults to `true`, or `false` when `debounceMs` is set.
+     */
+	leading?: boolean;
+
+    /**
+     *  trailing: Calls the listener with the last event of a burst once it
+     *  settles. Defaults to `true`.
+     */
+	trailing?: boolean;
+}
+
+/**
+ *  Options given to {@link Device.startMeter}.
+ */
+export interface MeterOptions {
+    /**
+     *  rateHz: The number of peak readings per second, between 1 and 1000.
+     *  Defaults to 25. A meter already started by another wrapper keeps
+     *  its rate.
+     */
+	rateHz?: number;
+}
+
+/**
+ *  Options given to {@link Device.startLoudness}.
+ */
+export interface LoudnessOptions {
+    /**
+     *  intervalMs: The time between two `loudness` events, between 10 and
+     *  60000 ms. Defaults to 100. A meter already started by another
+     *  wrapper keeps its interval.
+     */
+	intervalMs?: number;
+}
+
+/**
+ *  The value of a `loudness` event, in LUFS as defined by EBU R128.
+ *  Readings are `-Infinity` until enough audio has been measured, or while
+ *  the signal is silent.
+ */
+export interface LoudnessReading {
+    /**
+     *  momentary: The loudness of the last 400 ms.
+     */
+	momentary: number;
+
+    /**
+     *  shortTerm: The loudness of the last 3 s.
+     */
+	shortTerm: number;
+
+    /**
+     *  integrated: The gated loudness since the meter was started.
+     */
+	integrated: number;
+
+    /**
+     *  samplePeak: The highest absolute sample since the previous event,
+     *  linear, 1 being full scale.
+     */
+	samplePeak: number;
+}
+
+/**
+ *  Options given to {@link AudioSession.startSilenceDetection}.
+ */
+export interface SilenceOptions {
+    /**
+     *  threshold: The peak amplitude in `[0, 1]` below which the session is
+     *  considered silent. Defaults to `0.001`, that is -60 dBFS.
+     */
+	threshold?: number;
+
+    /**
+     *  holdMs: How long the session must stay below the threshold to
+     *  become inactive, between 100 and 600000 ms. Defaults to 1000.
+     */
+	holdMs?: number;
+}
+
+/**
+ *  Options given to {@link SoundMixer.duck}.
+ */
+export interface DuckOptions {
+    /**
+     *  depth: The attenuation of the ducked sessions in dB, at most 60.
+     *  Defaults to 12.
+     */
+	depth?: number;
+
+    /**
+     *  attackMs: The duration of the ramp down, up to 60000 ms. Defaults
+     *  to 50.
+     */
+	attackMs?: number;
+
+    /**
+     *  releaseMs: The duration of the ramp back up, up to 60000 ms.
+     *  Defaults to 500.
+     */
+	releaseMs?: number;
+}
+
+/**
+ *  Options given to {@link Device.startSpectrum}.
+ */
+export interface SpectrumOptions {
+    /**
+     *  size: The FFT size, a power of two between 64 and 16384. Defaults
+     *  to 2048.
+     */
+	size?: number;
+
+    /**
+     *  hop: The number of samples between two spectra, at most `size`.
+     *  Defaults to half the size.
+     */
+	hop?: number;
+
+    /**
+     *  window: The window applied before the FFT. Defaults to `hann`.
+     */
+	window?: "rect" | "hann" | "hamming" | "blackman";
+
+    /**
+     *  bands: The number of log spaced bands between 20 Hz and 24 kHz, at
+     *  most 256 and `size / 2`. Defaults to 32.
+     */
+	bands?: number;
+}
+
+/**
+ *  The format of interleaved PCM given to {@link SoundMixer.uploadSample}.
+ */
+export interface SampleSpec {
+    /**
+     *  format: The sample format, little endian. Defaults to `s16le`.
+     */
+	format?: "s16le" | "s32le" | "float32le";
+
+    /**
+     *  rate: The sample rate in Hz. Defaults to 48000.
+     */
+	rate?: number;
+
+    /**
+     *  channels: The number of interleaved channels. Defaults to 2.
+     */
+	channels?: number;
+}
+
+/**
+ *  Options given to {@link Device.openCapture}.
+ */
+export interface CaptureOptions extends SampleSpec {
+    /**
+     *  fragmentMs: The requested duration of a fragment, between 1 and
+     *  1000 ms. Defaults to 10.
+     */
+	fragmentMs?: number;
+}
+
+/**
+ *  A recording stream returned by {@link Device.openCapture}.
+ *  @remarks Only available on linux.
+ */
+export declare class Capture {
+
+	private constructor();
+
+    /**
+     *  The sample format of the fragments.
+     *  @readonly
+     */
+	public readonly format: "s16le" | "s32le" | "float32le";
+
+    /**
+     *  The sample rate of the fragments in Hz.
+     *  @readonly
+     */
+	public readonly rate: number;
+
+    /**
+     *  The number of interleaved channels of the fragments.
+     *  @readonly
+     */
+	public readonly channels: number;
+
+    /**
+     *  Closes the stream, no fragment is delivered afterwards. An open
+     *  capture is not garbage collected until it is closed.
+     */
+    public close(): void
+}
+
+/**
+ *  Options given to {@link SoundMixer.createGroup}.
+ */
+export interface GroupOptions {
+    /**
+     *  mode: `absolute` gives every member the volume of the group,
+     *  `relative` scales the members so that the loudest one gets it,
+     *  keeping their proportions. Defaults to `absolute`.
+     */
+	mode?: "absolute" | "relative";
+}
+
+/**
+ *  Devices and audio sessions moved together, returned by
+ *  {@link SoundMixer.createGroup}. Every member is read, and then written,
+ *  with all the requests sent back to back and awaited together.
+ *  @remarks Only available on linux.
+ */
+export declare class VolumeGroup {
+
+	private constructor();
+
+    /**
+     *  How the volume of the group is applied to its members.
+     *  @readonly
+     */
+	public readonly mode: "absolute" | "relative";
+
+    /**
+     *  The volume of the loudest channel of the group. In relative mode,
+     *  the members keep the proportions they had when the group was last
+     *  set while not silent.
+     */
+	public volume: VolumeScalar;
+
+    /**
+     *  Whether every member is muted.
+     */
+	public mute: boolean;
+}
+
+/**
+ *  A property matcher used in a {@link ListenerSelector}, either an exact
+ *  string or a regular expression.
+ *  @remarks Regular expressions are evaluated natively with the ECMAScript
+ *  grammar of the C++ standard library, only their `i` flag is honoured.
+ */
+export type PropertyMatcher = string | RegExp
+
+/**
+ *  Describes the devices and sessions a listener registered with
+ *  {@link SoundMixer.on} applies to. Omitted fields match anything.
+ */
+export interface ListenerSelector {
+    /**
+     *  type: Whether to match devices or audio sessions.
+     */
+	type?: "device" | "session";
+
+    /**
+     *  deviceType: The type of the device, or of the device owning the
+     *  session.
+     */
+	deviceType?: DeviceType;
+
+    /**
+     *  name: The name of the device or session.
+     */
+	name?: PropertyMatcher;
+
+    /**
+     *  appName: The application name of the session.
+     */
+	appName?: PropertyMatcher;
+
+    /**
+     *  device: The name of the device, or of the device owning the session.
+     */
+	device?: PropertyMatcher;
+}
+
+/**
+ *  Describes the new audio sessions a {@link SessionRule} applies to.
+ *  Omitted fields match anything, missing properties read as `""`.
+ */
+export interface SessionRuleMatch {
+    /**
+     *  deviceType: The type of the device owning the session.
+     */
+	deviceType?: DeviceType;
+
+    /**
+     *  appName: The application name of the session.
+     */
+	appName?: PropertyMatcher;
+
+    /**
+     *  binary: The executable of the application, its
+     *  `application.process.binary` property.
+     */
+	binary?: PropertyMatcher;
+
+    /**
+     *  role: The `media.role` of the stream, such as `music` or `phone`.
+     */
+	role?: PropertyMatcher;
+}
+
+/**
+ *  Settings applied to a new audio session, see
+ *  {@link SoundMixer.setRules}. Omitted settings are left untouched.
+ */
+export interface SessionRule {
+    /**
+     *  match: The sessions the rule applies to.
+     */
+	match?: SessionRuleMatch;
+
+    /**
+     *  volume: The volume every channel of the session starts with.
+     */
+	volume?: VolumeScalar;
+
+    /**
+     *  mute: Whether the session starts muted.
+     */
+	mute?: boolean;
+
+    /**
+     *  maxVolume: The loudest the session may be, a louder session being
+     *  scaled down as a whole.
+     */
+	maxVolume?: VolumeScalar;
+}
+
 /**
  *  A class that represents an actual physical or virtual audio device.
  */
@@ -77,6 +460,53 @@ export declare class Device {
      */
 	public balance: VolumeBalance
 
+    /**
+     *  The volume of every channel of the device.
+     *  @remarks Writing a `Float32Array` sets the channels in order,
+     *  writing a {@link ChannelVolumes} sets the listed positions only.
+     *  Only available on linux.
+     */
+	public channels: ChannelVolumes | Float32Array
+
+    /**
+     *  Moves the volume of the device by `delta`.
+     *  @param {number} delta - The amount to add to the volume, negative to
+     *  lower it.
+     *  @returns {VolumeScalar} - The volume that was set.
+     *  @remarks Unlike `device.volume += delta`, this issues a single
+     *  volume change from the last known value and keeps the balance
+     *  between the channels. On windows the volume is clamped to `[0, 1]`.
+     *  On linux it is clamped to the greater of 100% and its loudest
+     *  channel, so an amplified volume is kept rather than cut down to
+     *  100%, and may be returned above `1`.
+     */
+    public stepVolume(delta: number): VolumeScalar
+
+    /**
+     *  The average volume of the channels as an unscaled server value,
+     *  `65536` being the nominal volume.
+     *  @remarks Only available on linux.
+     *  @readonly
+     */
+	public readonly rawVolume: number
+
+    /**
+     *  The unscaled server volume of every channel, in channel order.
+     *  @remarks Only available on linux.
+     *  @readonly
+     */
+	public readonly rawChannels: Uint32Array
+
+    /**
+     *  Writes unscaled server volumes as is, avoiding any conversion to and
+     *  from {@link VolumeScalar} so that values read from
+     *  {@link Device.rawChannels} can be written back without drift.
+     *  @param {number | Uint32Array} volume - A volume applied to every
+     *  channel, or one volume per channel in channel order.
+     *  @remarks Only available on linux.
+     */
+    public setRawVolume(volume: number | Uint32Array): void
+
     /**
      *  The name of the device.
      *  @readonly
@@ -97,11 +527,16 @@ export declare class Device {
 
     /**
      *  @param {string} ev - The type of event to subscribe to. 
-     *  It can be either `volume`, or `mute`.
+     *  It can be either `volume`, `mute`, or on linux `peak` once
+     *  {@link Device.startMeter} has been called and `loudness` once
+     *  {@link Device.startLoudness} has been called.
      *
      *  @param {function} callback - The callback to run when the event is
      *  triggered.
      *
+     *  @param {ListenerOptions} options - Optional rate limiting and
+     *  debouncing of the callback.
+     *
      *  @returns {number} - The id of the registered callback used to 
      *  remove the listener.
      *
@@ -111,7 +546,8 @@ export declare class Device {
      *
      *  @see {@link Device.removeListener | removing a listener}
      */
-    public on(ev: string, callback: (payload) => void): number
+    public on(ev: string, callback: (payload) => void,
+        options?: ListenerOptions): number
 
     /**
      *  @param {string} ev - The type of event to remove the listener of. 
@@ -124,6 +560,180 @@ export declare class Device {
      *  @see {@link Device.on | registering a listener}
      */
     public removeListener(ev: string, handler: number): boolean
+
+    /**
+     *  Starts measuring the signal level of the device, a sink being
+     *  measured through its monitor source. Every reading triggers the
+     *  `peak` event with the peak amplitude of the interval, in `[0, 1]`.
+     *
+     *  @param {MeterOptions} options - The rate of the readings.
+     *
+     *  @returns {boolean} - Whether the meter is running.
+     *
+     *  @remarks Only available on linux. The measuring stream is shared by
+     *  every wrapper of the device and closed by the last
+     *  {@link Device.stopMeter} call, on dispose, or when the device is
+     *  removed. A metering object is not garbage collected until it is
+     *  stopped or disposed.
+     */
+    public startMeter(options?: MeterOptions): boolean
+
+    /**
+     *  Starts measuring the loudness of the device as specified by EBU
+     *  R128, a sink being measured through its monitor source at its own
+     *  rate and channel layout. Every `intervalMs` the `loudness` event is
+     *  triggered with a {@link LoudnessReading}.
+     *
+     *  @param {LoudnessOptions} options - The interval of the readings.
+     *
+     *  @returns {boolean} - Whether the meter is running.
+     *
+     *  @remarks Only available on linux. The meter is shared by every
+     *  wrapper of the device, its integrated loudness covering the time
+     *  since the first of them started it. It is closed by the last
+     *  {@link Device.stopLoudness} call, on dispose, or when the device is
+     *  removed, and keeps the object from being garbage collected until
+     *  then.
+     */
+    public startLoudness(options?: LoudnessOptions): boolean
+
+    /**
+     *  Stops the meter started by {@link Device.startLoudness}.
+     *  @returns {boolean} - Whether a meter was running.
+     *  @remarks Only available on linux.
+     */
+    public stopLoudness(): boolean
+
+    /**
+     *  Caps the volume of the device: its loudest channel is scaled back to
+     *  `max` natively, as soon as the server reports anyone raising it
+     *  above, so that the violating volume is never reported to JS.
+     *
+     *  @param {VolumeScalar | null} max - The highest volume allowed, or
+     *  `null` to remove the cap.
+     *
+     *  @returns {boolean} - Whether the cap is enforced.
+     *
+     *  @remarks Only available on linux. The cap belongs to the device
+     *  rather than to this object, and lasts until it is removed or the
+     *  device disappears.
+     */
+    public setMaxVolume(max: VolumeScalar | null): boolean
+
+    /**
+     *  Plays a sample uploaded with {@link SoundMixer.uploadSample}. The
+     *  server mixes it from its cache, without any stream to open, which
+     *  suits short notification sounds.
+     *
+     *  @param {string} name - The name of the sample.
+     *
+     *  @param {VolumeScalar} [volume] - The volume of the sample, the
+     *  server default when omitted.
+     *
+     *  @returns {boolean} - Whether the sample started playing.
+     *
+     *  @throws If the device is not a render device.
+     *
+     *  @remarks Only available on linux.
+     */
+    public playSample(name: string, volume?: VolumeScalar): boolean
+
+    /**
+     *  Stops the meter started by {@link Device.startMeter}.
+     *  @returns {boolean} - Whether a meter was running.
+     *  @remarks Only available on linux.
+     */
+    public stopMeter(): boolean
+
+    /**
+     *  A ring of the latest meter readings written natively, to be polled
+     *  (e.g. on `requestAnimationFrame`) instead of listening to `peak`
+     *  events. `null` while the meter is stopped, and detached from the
+     *  meter once it stops.
+     *
+     *  The buffer starts with four 32 bits words: `sequence`, `written`,
+     *  `capacity` and `width`, followed by `capacity` slots of `width`
+     *  floats. `sequence` is odd while a slot is being written: read it,
+     *  read the slots, and retry if it was odd or has changed.
+     *
+     *  @example
+     *  const header = new Uint32Array(buffer, 0, 4)
+     *  const slots = new Float32Array(buffer, 16)
+     *  let seq, peak
+     *  do {
+     *      seq = header[0]
+     *      peak = slots[(header[1] - 1) % header[2]]
+     *  } while (seq & 1 || seq !== header[0])
+     *
+     *  @remarks Only available on linux.
+     *  @readonly
+     */
+	public readonly meterBuffer: ArrayBuffer | null
+
+    /**
+     *  Records the device, a sink being recorded through its monitor
+     *  source, and calls `callback` with every fragment of interleaved
+     *  samples. The fragments are not copied again on their way to JS.
+     *
+     *  @param {CaptureOptions} options - The format of the samples.
+     *  @param callback - Called with each fragment, then with `null` if
+     *  the stream is ended by the server.
+     *
+     *  @returns {Capture} - The stream, to be closed with
+     *  {@link Capture.close}.
+     *
+     *  @remarks Only available on linux. Fragments are dropped while the
+     *  JS thread is too busy to keep up.
+     */
+    public openCapture(options: CaptureOptions,
+        callback: (data: ArrayBuffer | null) => void): Capture
+    public openCapture(callback: (data: ArrayBuffer | null) => void): Capture
+
+    /**
+     *  Starts a spectrum analyser on the device, a sink being analysed
+     *  through its monitor source downmixed to mono at 48 kHz. Every `hop`
+     *  samples the spectrum is reduced to `bands` amplitudes, a full scale
+     *  sine reading about `1`, and written to
+     *  {@link Device.spectrumBuffer}.
+     *
+     *  @param {SpectrumOptions} options - The analysis settings, a running
+     *  analyser being restarted with them.
+     *
+     *  @returns {boolean} - Whether the analyser is running.
+     *
+     *  @remarks Only available on linux. A running analyser keeps the
+     *  object from being garbage collected until it is stopped or
+     *  disposed.
+     */
+    public startSpectrum(options?: SpectrumOptions): boolean
+
+    /**
+     *  Stops the analyser started by {@link Device.startSpectrum}.
+     *  @returns {boolean} - Whether an analyser was running.
+     *  @remarks Only available on linux.
+     */
+    public stopSpectrum(): boolean
+
+    /**
+     *  A ring of the latest spectra, laid out like
+     *  {@link Device.meterBuffer} with one slot of `bands` floats per
+     *  spectrum, from the lowest band to the highest. `null` while the
+     *  analyser is stopped.
+     *
+     *  @remarks Only available on linux.
+     *  @readonly
+     */
+	public readonly spectrumBuffer: ArrayBuffer | null
+
+    /**
+     *  Releases the native handle of the device and the listeners
+     *  registered through this object right away, instead of waiting for
+     *  the garbage collector. Any later use of the object throws.
+     *
+     *  @remarks Also available as `[Symbol.dispose]` on runtimes defining
+     *  it, so the object can be bound with `using`.
+     */
+    public dispose(): void
 }
 
 /**
@@ -186,12 +796,78 @@ export declare class AudioSession {
      */
 	public balance: VolumeBalance
 
+    /**
+     *  The volume of every channel of the {@link AudioSession}.
+     *  @see {@link Device.channels}.
+     */
+	public channels: ChannelVolumes | Float32Array
+
     /**
      *  The mute flag of the {@link AudioSession}.
      *  @see {@link Device.mute}.
      */
 	public mute: boolean
 
+    /**
+     *  Moves the volume of the {@link AudioSession} by `delta`.
+     *  @see {@link Device.stepVolume}
+     */
+    public stepVolume(delta: number): VolumeScalar
+
+    /**
+     *  @see {@link Device.rawVolume}
+     *  @readonly
+     */
+	public readonly rawVolume: number
+
+    /**
+     *  @see {@link Device.rawChannels}
+     *  @readonly
+     */
+	public readonly rawChannels: Uint32Array
+
+    /**
+     *  @see {@link Device.setRawVolume}
+     */
+    public setRawVolume(volume: number | Uint32Array): void
+
+    /**
+     *  Starts measuring the signal level of the {@link AudioSession}. The
+     *  readings trigger the `peak` event of the listeners registered with
+     *  {@link SoundMixer.on} whose selector matches the session.
+     *
+     *  @remarks Only available on linux. Playback sessions are measured
+     *  alone, recording sessions through the source they record from.
+     *  @see {@link Device.startMeter}
+     */
+    public startMeter(options?: MeterOptions): boolean
+
+    /**
+     *  @see {@link Device.stopMeter}
+     */
+    public stopMeter(): boolean
+
+    /**
+     *  @see {@link Device.meterBuffer}
+     *  @readonly
+     */
+	public readonly meterBuffer: ArrayBuffer | null
+
+    /**
+     *  Starts measuring the loudness of the {@link AudioSession}. The
+     *  readings trigger the `loudness` event of the listeners registered
+     *  with {@link SoundMixer.on} whose selector matches the session.
+     *
+     *  @remarks Only available on linux.
+     *  @see {@link Device.startLoudness}
+     */
+    public startLoudness(options?: LoudnessOptions): boolean
+
+    /**
+     *  @see {@link Device.stopLoudness}
+     */
+    public stopLoudness(): boolean
+
     /**
      *  The name of the {@link AudioSession}.
      *  @remarks Depending on the `C++` background implementation,
@@ -210,9 +886,66 @@ export declare class AudioSession {
 
     /**
      * The state of the {@link AudioSession}.
+     * @remarks On linux, a session is `INACTIVE` while its stream is
+     * corked (paused), or silent as decided by
+     * {@link AudioSession.startSilenceDetection}, and `EXPIRED` once it
+     * has been removed.
      * @readonly
      */
 	public readonly state: AudioSessionState
+
+    /**
+     *  Starts watching the signal of the session with a low rate meter,
+     *  so that it is considered inactive once it has stayed silent for
+     *  `holdMs`, even though its stream is not corked.
+     *
+     *  Whether a session is active is reported by the `activeChanged`
+     *  event of the listeners registered with {@link SoundMixer.on},
+     *  which receive `true` or `false`. Without a detector, it follows the
+     *  corked state of the stream only.
+     *
+     *  @param {SilenceOptions} options - The silence threshold.
+     *
+     *  @returns {boolean} - Whether the detector is running.
+     *
+     *  @remarks Only available on linux. Detectors share the meter of the
+     *  session without triggering `peak` events, the first of them setting
+     *  the threshold. A detecting object is not garbage collected until it
+     *  is stopped or disposed.
+     */
+    public startSilenceDetection(options?: SilenceOptions): boolean
+
+    /**
+     *  Stops the detector started by
+     *  {@link AudioSession.startSilenceDetection}.
+     *  @returns {boolean} - Whether a detector was running.
+     *  @remarks Only available on linux.
+     */
+    public stopSilenceDetection(): boolean
+
+    /**
+     *  Caps the volume of the session.
+     *  @param {VolumeScalar | null} max - The highest volume allowed, or
+     *  `null` to remove the cap.
+     *  @returns {boolean} - Whether the cap is enforced.
+     *  @see {@link Device.setMaxVolume}
+     */
+    public setMaxVolume(max: VolumeScalar | null): boolean
+
+    /**
+     *  Moves the session to another device, where it keeps playing or
+     *  recording.
+     *  @param {Device} device - A device of the type of the session.
+     *  @returns {boolean} - Whether the server moved the session.
+     *  @remarks Only available on linux.
+     */
+    public moveTo(device: Device): boolean
+
+    /**
+     *  Releases the native handle of the {@link AudioSession} right away.
+     *  @see {@link Device.dispose}
+     */
+    public dispose(): void
 }
 
 /**
@@ -224,19 +957,219 @@ export declare type SoundMixer = {
 
     /**
      *  The list of active {@link Device | devices} when the property is
-     *  read.
+     *  read. On Linux a device that is still referenced from JS is returned
+     *  as the same object.
      *  @static
      */
 	devices: Device[];
 
     /**
-     *  Gets the default device of the given type.
+     *  Debugging counters of the notification pool, since the module was
+     *  loaded. Misses growing with the hits mean that events arrive faster
+     *  than JS handles them.
+     *  @static
+     */
+	readonly poolStats: PoolStats;
+
+    /**
+     *  Gets the default device of the given type, as set by the server.
      *  @param {DeviceType} type - The type of the device to be retrieved.
      *  @returns {Device} - The default {@link Device} if found, null
      *  otherwise.
      *  @static
      */
 	getDefaultDevice(type: DeviceType): Device;
+
+    /**
+     *  Makes a device the default of its type, that new streams are
+     *  played on or recorded from.
+     *
+     *  @param {Device} device - The new default device.
+     *
+     *  @param {Object} options - With `moveSessions`, the existing
+     *  sessions of the type of the device are moved to it as well, in the
+     *  same round trip.
+     *
+     *  @returns {boolean} - Whether the server accepted the new default
+     *  and, with `moveSessions`, moved every session. A session removed
+     *  while being moved also counts as a failure.
+     *
+     *  @remarks Only available on linux.
+     *  @static
+     */
+	setDefaultDevice(device: Device,
+		options?: { moveSessions?: boolean }): boolean;
+
+    /**
+     *  The scale of every volume read or written through the mixer:
+     *  `linear` (the default) is the fraction of the nominal volume,
+     *  `cubic` its amplitude factor and `dB` the attenuation in decibels,
+     *  `-Infinity` when silent.
+     *
+     *  @remarks Only available on linux.
+     *  @static
+     */
+	volumeScale: "linear" | "cubic" | "dB";
+
+    /**
+     *  Replaces the rules applied to every audio session created from now
+     *  on. The first rule matching a new session sets its volume and mute
+     *  natively, as soon as the server announces the session and before
+     *  any listener is called, so that it never plays at its initial
+     *  volume for more than a round trip.
+     *
+     *  @param {SessionRule[]} rules - The rules, in order of precedence.
+     *  An empty array disables them.
+     *
+     *  @returns {boolean} - Whether the rules will be applied.
+     *
+     *  @remarks Only available on linux. Sessions that already exist are
+     *  left alone, and `maxVolume` caps a matching session for its whole
+     *  life, as {@link AudioSession.setMaxVolume} does.
+     *  Volumes are read in the {@link SoundMixer.volumeScale} in effect
+     *  when the rules are set.
+     *  @static
+     */
+	setRules(rules: SessionRule[]): boolean;
+
+    /**
+     *  Groups devices and audio sessions, so that they are moved together
+     *  in one round trip rather than one per member.
+     *
+     *  @param {Array<Device | AudioSession>} members - The objects to
+     *  group. Members removed afterwards are skipped.
+     *
+     *  @param {GroupOptions} options - How the group volume is applied.
+     *
+     *  @returns {VolumeGroup} - The group.
+     *
+     *  @remarks Only available on linux.
+     *  @static
+     */
+	createGroup(members: Array<Device | AudioSession>,
+		options?: GroupOptions): VolumeGroup;
+
+    /**
+     *  Moves every {@link AudioSession} matching the selector to a device,
+     *  such as all the streams of an application, or all the streams of
+     *  another device with a `device` matcher. The moves are sent
+     *  together, and awaited in a single round trip.
+     *
+     *  @param {ListenerSelector} selector - The sessions to move. Only the
+     *  sessions of the type of `device` are considered.
+     *
+     *  @param {Device} device - The device to move them to.
+     *
+     *  @returns {number} - The number of sessions moved.
+     *
+     *  @remarks Only available on linux.
+     *  @static
+     */
+	moveSessions(selector: ListenerSelector, device: Device): number;
+
+    /**
+     *  Uploads a sound to the sample cache of the server once, so that
+     *  {@link Device.playSample} starts it without opening a stream.
+     *  A sample of the same name is replaced.
+     *
+     *  @param {string} name - The name of the sample.
+     *
+     *  @param {ArrayBuffer | ArrayBufferView} pcm - Interleaved frames in
+     *  the format of `spec`.
+     *
+     *  @param {SampleSpec} [spec] - The format of `pcm`, 16 bit stereo at
+     *  48 kHz by default.
+     *
+     *  @returns {boolean} - Whether the server stored the sample.
+     *
+     *  @remarks Only available on linux. Samples live in the server until
+     *  they are removed or the server restarts.
+     *  @static
+     */
+	uploadSample(name: string, pcm: ArrayBuffer | ArrayBufferView,
+		spec?: SampleSpec): boolean;
+
+    /**
+     *  Removes a sample uploaded with {@link SoundMixer.uploadSample}.
+     *  @returns {boolean} - Whether the sample existed.
+     *  @remarks Only available on linux.
+     *  @static
+     */
+	removeSample(name: string): boolean;
+
+    /**
+     *  Lowers every {@link AudioSession} matching `target` while a session
+     *  matching `trigger` is active, and restores them once no trigger is.
+     *  The volume is ramped natively, in dB, starting from the server
+     *  event that changed the activity of the trigger.
+     *
+     *  A trigger is active while its stream is not corked, and while its
+     *  signal is not silent if it runs a detector started by
+     *  {@link AudioSession.startSilenceDetection}.
+     *
+     *  @param {ListenerSelector} trigger - The sessions that cause ducking.
+     *
+     *  @param {ListenerSelector} target - The sessions to duck, those also
+     *  matching `trigger` being left alone.
+     *
+     *  @param {DuckOptions} options - The depth and ramp durations.
+     *
+     *  @returns {number} - The id used to stop the ducking, `-1` if it
+     *  could not be started.
+     *
+     *  @remarks Only available on linux. A volume set on a ducked session
+     *  becomes the volume it is restored to. A session should only be the
+     *  target of one ducker.
+     *  @static
+     */
+	duck(trigger: ListenerSelector, target: ListenerSelector,
+		options?: DuckOptions): number;
+
+    /**
+     *  Restores the sessions ducked by {@link SoundMixer.duck} at once.
+     *  @param {number} handler - The id returned by {@link SoundMixer.duck}.
+     *  @returns {boolean} - Whether the ducking was running.
+     *  @remarks Only available on linux.
+     *  @static
+     */
+	stopDucking(handler: number): boolean;
+
+    /**
+     *  Registers a listener on every present and future {@link Device} or
+     *  {@link AudioSession} matching the selector.
+     *
+     *  @param {string} ev - The type of event to subscribe to. 
+     *  It can be either `volume`, `mute`, `activeChanged` for sessions, or
+     *  `peak` and `loudness` for metered objects.
+     *
+     *  @param {ListenerSelector} selector - The objects to listen to.
+     *
+     *  @param {function} callback - The callback to run when the event is
+     *  triggered, it receives the new value and the object that changed.
+     *
+     *  @param {ListenerOptions} options - Optional rate limiting and
+     *  debouncing, applied to each matched object separately.
+     *
+     *  @returns {number} - The id of the registered callback used to 
+     *  remove the listener.
+     *
+     *  @remarks Only available on linux.
+     *  @static
+     */
+	on(ev: string, selector: ListenerSelector,
+		callback: (payload, target: Device | AudioSession) => void,
+		options?: ListenerOptions): number;
+
+    /**
+     *  @param {string} ev - The type of event to remove the listener of. 
+     *
+     *  @param {number} handler - The identifier returned by
+     *  {@link SoundMixer.on}.
+     *
+     *  @returns {boolean} - Whether the callback was unregistered or not.
+     *  @static
+     */
+	removeListener(ev: string, handler: number): boolean;
 }
 
 /**
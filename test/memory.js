@@ -24,7 +24,9 @@ setInterval(() => {
 		for (const s of d.sessions) {
 			s.volume = s.volume
 			s.mute = s.mute
+			s.dispose()
 		}
+		d.dispose()
 	}
 
 }, 1);
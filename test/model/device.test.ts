@@ -1,4 +1,5 @@
 import { random, clamp } from "lodash";
+import { platform } from "os"
 import "../../dist/@types/sound-mixer.d.ts"
 import SoundMixer, { Device, DeviceType } from "../../dist/sound-mixer.js"
 
@@ -35,6 +36,18 @@ describe("set device volume", () => {
 		expect(device.volume).toBe(1.)
 	})
 
+	it("should step the volume", () => {
+		device.volume = .5
+		expect(device.stepVolume(.1)).toBeCloseTo(.6, 2)
+		expect(device.stepVolume(-.2)).toBeCloseTo(.4, 2)
+		expect(device.volume).toBeCloseTo(.4, 2)
+	})
+
+	it("should clamp the stepped volume", () => {
+		expect(device.stepVolume(2)).toBe(1.)
+		expect(device.stepVolume(-2)).toBe(0)
+	})
+
 	afterAll(() => {
 		device.volume = originalVolume;
 	})
@@ -127,3 +140,236 @@ describe("volume balance", () => {
 	})
 
 })
+
+const linuxDescribe = platform() === "linux" ? describe : describe.skip
+
+linuxDescribe("channel volumes", () => {
+
+	let device: Device;
+	let previous: Float32Array;
+	beforeAll(() => {
+		const devices = SoundMixer.devices;
+		device = devices[random(0, devices.length - 1)];
+		previous = (device.channels as { volumes: Float32Array }).volumes;
+	});
+
+	it("should list every channel", () => {
+		const { positions, volumes } = device.channels as {
+			positions: Uint8Array, volumes: Float32Array }
+		expect(positions).toBeInstanceOf(Uint8Array)
+		expect(volumes).toBeInstanceOf(Float32Array)
+		expect(positions.length).toBe(volumes.length)
+	})
+
+	it("should set the channels in order", () => {
+		device.channels = new Float32Array(previous.length).fill(.5)
+		const { volumes } = device.channels as { volumes: Float32Array }
+		volumes.forEach(v => expect(v).toBeCloseTo(.5, 2))
+	})
+
+	it("should reject untyped volumes", () => {
+		expect(() => device.channels = [.5, .5] as never).toThrow()
+	})
+
+	it("should write raw volumes back without drift", () => {
+		const raw = device.rawChannels
+		for (let i = 0; i < 10; i++)
+			device.setRawVolume(device.rawChannels)
+		expect(device.rawChannels).toEqual(raw)
+		device.setRawVolume(32768)
+		expect(device.rawVolume).toBe(32768)
+	})
+
+	it("should not lower an amplified volume when stepping up", () => {
+		device.setRawVolume(98304)
+		device.stepVolume(.05)
+		expect(device.rawVolume).toBeGreaterThanOrEqual(98304)
+	})
+
+	afterAll(() => {
+		device.channels = previous;
+	})
+})
+
+linuxDescribe("device meter", () => {
+
+	let device: Device;
+	beforeAll(() => {
+		device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+	});
+
+	it("should share the meter of a device", () => {
+		const handler = device.on("peak", () => undefined)
+		expect(device.startMeter({ rateHz: 10 })).toBe(true)
+		expect(device.startMeter()).toBe(true)
+		expect(device.stopMeter()).toBe(true)
+		expect(device.stopMeter()).toBe(false)
+		expect(device.removeListener("peak", handler)).toBe(true)
+	})
+
+	it("should reject an invalid rate", () => {
+		expect(() => device.startMeter({ rateHz: 0 })).toThrow()
+	})
+
+	it("should expose a ring while metering", () => {
+		expect(device.meterBuffer).toBeNull()
+		device.startMeter()
+		const buffer = device.meterBuffer
+		expect(buffer).toBe(device.meterBuffer)
+		const [sequence, , capacity, width] = new Uint32Array(buffer, 0, 4)
+		expect(sequence % 2).toBe(0)
+		expect(buffer.byteLength).toBe(16 + capacity * width * 4)
+		device.stopMeter()
+		expect(device.meterBuffer).toBeNull()
+	})
+})
+
+linuxDescribe("device loudness", () => {
+
+	it("should share the loudness meter of a device", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+		const handler = device.on("loudness", () => undefined)
+		expect(device.startLoudness({ intervalMs: 200 })).toBe(true)
+		expect(device.stopLoudness()).toBe(true)
+		expect(device.stopLoudness()).toBe(false)
+		device.removeListener("loudness", handler)
+	})
+
+	it("should reject invalid intervals", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+		expect(() => device.startLoudness({ intervalMs: 1 })).toThrow()
+	})
+
+	it("should report the sample peak of an interval", async () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+		const reading = await new Promise<{ samplePeak: number }>((resolve) => {
+			const handler = device.on("loudness", (value) => {
+				device.removeListener("loudness", handler)
+				resolve(value)
+			})
+			device.startLoudness({ intervalMs: 50 })
+		})
+		device.stopLoudness()
+		expect(reading.samplePeak).toBeGreaterThanOrEqual(0)
+	})
+})
+
+linuxDescribe("device spectrum", () => {
+
+	it("should publish the bands in a ring", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+		expect(device.spectrumBuffer).toBeNull()
+		expect(device.startSpectrum({ size: 1024, bands: 16 })).toBe(true)
+		const buffer = device.spectrumBuffer
+		const [, , capacity, width] = new Uint32Array(buffer, 0, 4)
+		expect(width).toBe(16)
+		expect(buffer.byteLength).toBe(16 + capacity * width * 4)
+		expect(device.stopSpectrum()).toBe(true)
+		expect(device.stopSpectrum()).toBe(false)
+		expect(device.spectrumBuffer).toBeNull()
+	})
+
+	it("should reject invalid options", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+		expect(() => device.startSpectrum({ size: 1000 })).toThrow()
+		expect(() => device.startSpectrum({ window: "kaiser" as "hann" }))
+			.toThrow()
+	})
+})
+
+linuxDescribe("device volume cap", () => {
+	let device: Device;
+	let originalVolume: number;
+	beforeAll(() => {
+		device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+		originalVolume = device.volume;
+	});
+
+	it("should scale a louder volume back to the cap", async () => {
+		expect(device.setMaxVolume(.5)).toBe(true)
+		device.volume = 1
+		await new Promise((resolve) => setTimeout(resolve, 200))
+		expect(device.volume).toBeLessThanOrEqual(.51)
+	})
+
+	it("should reject an invalid cap", () => {
+		expect(() => device.setMaxVolume(2)).toThrow()
+	})
+
+	afterAll(() => {
+		device.setMaxVolume(null)
+		device.volume = originalVolume;
+	})
+})
+
+linuxDescribe("device capture", () => {
+
+	it("should open and close a capture stream", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+		const capture = device.openCapture(
+			{ format: "float32le", channels: 1 }, () => undefined)
+		expect(capture.format).toBe("float32le")
+		expect(capture.rate).toBe(48000)
+		expect(capture.channels).toBe(1)
+		capture.close()
+		capture.close()
+	})
+
+	it("should reject invalid options", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER);
+		expect(() => device.openCapture({ fragmentMs: 0 }, () => undefined))
+			.toThrow()
+	})
+})
+
+describe("device listeners", () => {
+	let device: Device;
+	beforeAll(() => {
+		const devices = SoundMixer.devices;
+		device = devices[random(0, devices.length - 1)];
+	});
+
+	it("should register a rate limited listener", () => {
+		const handler = device.on("volume", () => undefined, { maxRate: 60 })
+		expect(handler).toBeGreaterThanOrEqual(0)
+		expect(device.removeListener("volume", handler)).toBe(true)
+	})
+
+	it("should call a listener without options on every change",
+		async () => {
+			const original = device.volume
+			let calls = 0
+			const handler = device.on("volume", () => { calls++ })
+			device.volume = .2
+			await new Promise((resolve) => setTimeout(resolve, 100))
+			device.volume = .4
+			await new Promise((resolve) => setTimeout(resolve, 100))
+			device.removeListener("volume", handler)
+			device.volume = original
+			expect(calls).toBeGreaterThanOrEqual(2)
+		})
+
+	it("should accept fractional rates", () => {
+		const handler = device.on("volume", () => undefined, { maxRate: .5 })
+		expect(handler).toBeGreaterThanOrEqual(0)
+		expect(device.removeListener("volume", handler)).toBe(true)
+	})
+
+	it("should register a debounced listener", () => {
+		const handler = device.on("mute", () => undefined,
+			{ debounceMs: 100, leading: true })
+		expect(handler).toBeGreaterThanOrEqual(0)
+		expect(device.removeListener("mute", handler)).toBe(true)
+	})
+
+	it("should reject invalid options", () => {
+		expect(() => device.on("volume", () => undefined, { maxRate: -1 }))
+			.toThrow()
+		expect(() => device.on("volume", () => undefined, { maxRate: NaN }))
+			.toThrow()
+		expect(() => device.on("volume", () => undefined,
+			{ debounceMs: .0001 })).toThrow()
+		expect(() => device.on("volume", () => undefined,
+			{ leading: false, trailing: false })).toThrow()
+	})
+})
@@ -1,6 +1,7 @@
 import { random } from "lodash";
+import { platform } from "os"
 import "../../dist/@types/sound-mixer.d.ts"
-import SoundMixer, { DeviceType, Device, AudioSession } from "../../dist/sound-mixer.js"
+import SoundMixer, { DeviceType, Device, AudioSession, AudioSessionState } from "../../dist/sound-mixer.js"
 
 describe("audio session", () => {
 
@@ -72,4 +73,66 @@ describe("audio session", () => {
 			session.mute = mute;
 		})
 	});
+
+	const linuxDescribe = platform() === "linux" ? describe : describe.skip
+
+	linuxDescribe("meter", () => {
+		it("should deliver peaks to selector listeners", () => {
+			const handler = SoundMixer.on("peak",
+				{ type: "session", name: session.name }, () => undefined)
+			expect(session.startMeter({ rateHz: 30 })).toBe(true)
+			expect(session.stopMeter()).toBe(true)
+			expect(session.stopMeter()).toBe(false)
+			expect(SoundMixer.removeListener("peak", handler)).toBe(true)
+		})
+	});
+
+	linuxDescribe("state", () => {
+		it("should be active or inactive", () => {
+			expect([AudioSessionState.ACTIVE, AudioSessionState.INACTIVE])
+				.toContain(session.state)
+		})
+
+		it("should run a silence detector", () => {
+			const handler = SoundMixer.on("activeChanged",
+				{ type: "session", name: session.name }, () => undefined)
+			expect(session.startSilenceDetection({ holdMs: 500 })).toBe(true)
+			expect(session.stopSilenceDetection()).toBe(true)
+			expect(session.stopSilenceDetection()).toBe(false)
+			expect(SoundMixer.removeListener("activeChanged", handler))
+				.toBe(true)
+		})
+
+		it("should reject invalid options", () => {
+			expect(() => session.startSilenceDetection({ threshold: 2 }))
+				.toThrow()
+		})
+	});
+
+	linuxDescribe("move", () => {
+		it("should move to its own device", () => {
+			expect(session.moveTo(device)).toBe(true)
+			expect(SoundMixer.moveSessions({ name: session.name }, device))
+				.toBeGreaterThanOrEqual(1)
+		})
+
+		it("should reject a device of another type", () => {
+			const other = SoundMixer.devices
+				.find(({ type }) => type !== device.type)
+			expect(() => session.moveTo(other)).toThrow()
+		})
+	});
+
+	describe("dispose", () => {
+		it("should throw once disposed", () => {
+			session.dispose()
+			expect(() => session.volume).toThrow()
+			expect(() => session.mute = true).toThrow()
+		})
+
+		it("should be idempotent", () => {
+			session.dispose()
+			expect(() => session.dispose()).not.toThrow()
+		})
+	});
 });
@@ -1,6 +1,9 @@
+import { platform } from "os"
 import "../dist/@types/sound-mixer.d.ts"
 import SoundMixer, { DeviceType, Device } from "../dist/sound-mixer.js"
 
+const linuxIt = platform() === "linux" ? it : it.skip
+
 describe("sound mixer", () => {
 
 	it("should get all devices", () => {
@@ -22,4 +25,177 @@ describe("sound mixer", () => {
 		expect(device.type).toBe(DeviceType.CAPTURE)
 	})
 
+	it("should count the notification pool usage", () => {
+		const { hits, misses } = SoundMixer.poolStats
+		expect(hits).toBeGreaterThanOrEqual(0)
+		expect(misses).toBeGreaterThanOrEqual(0)
+		expect(SoundMixer.poolStats.hits).toBeGreaterThanOrEqual(hits)
+	})
+
+	linuxIt("should set the default device", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER)
+		expect(SoundMixer.setDefaultDevice(device)).toBe(true)
+		expect(SoundMixer.setDefaultDevice(device, { moveSessions: true }))
+			.toBe(true)
+		expect(SoundMixer.getDefaultDevice(DeviceType.RENDER)).toBe(device)
+		expect(() => SoundMixer.setDefaultDevice({} as Device)).toThrow()
+	})
+
+	linuxIt("should play a cached sample", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER)
+		// 10 ms of silence, 16 bit stereo at 48 kHz
+		const pcm = new Int16Array(2 * 480)
+		expect(SoundMixer.uploadSample("sound-mixer-test", pcm)).toBe(true)
+		expect(device.playSample("sound-mixer-test", 0.5)).toBe(true)
+		expect(SoundMixer.removeSample("sound-mixer-test")).toBe(true)
+		expect(device.playSample("sound-mixer-test")).toBe(false)
+		expect(() => SoundMixer.uploadSample("odd", new Uint8Array(3)))
+			.toThrow()
+	})
+
+	linuxIt("should return the same wrapper for the same device", () => {
+		const [first] = SoundMixer.devices
+		expect(SoundMixer.devices).toContain(first)
+		expect(SoundMixer.getDefaultDevice(first.type))
+			.toBe(SoundMixer.getDefaultDevice(first.type))
+	})
+
+	linuxIt("should register a selector listener", () => {
+		const handler = SoundMixer.on("volume",
+			{ type: "session", appName: /spotify/i }, () => undefined)
+		expect(handler).toBeGreaterThanOrEqual(0)
+		expect(SoundMixer.removeListener("volume", handler)).toBe(true)
+		expect(SoundMixer.removeListener("volume", handler)).toBe(false)
+	})
+
+	linuxIt("should call a selector listener with the matching object",
+		async () => {
+			const device = SoundMixer.getDefaultDevice(DeviceType.RENDER)
+			const original = device.volume
+			const received: unknown[] = []
+			const handler = SoundMixer.on("volume",
+				{ type: "device", deviceType: DeviceType.RENDER },
+				(_value, target) => { received.push(target) })
+			device.volume = original > .5 ? .3 : .7
+			await new Promise((resolve) => setTimeout(resolve, 200))
+			SoundMixer.removeListener("volume", handler)
+			device.volume = original
+			expect(received).toContain(device)
+		})
+
+	linuxIt("should reject an invalid selector", () => {
+		expect(() => SoundMixer.on("volume",
+			{ type: "stream" } as never, () => undefined)).toThrow()
+	})
+
+	linuxIt("should read volumes in the selected scale", () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER)
+		try {
+			SoundMixer.volumeScale = "dB"
+			expect(SoundMixer.volumeScale).toBe("dB")
+			expect(device.volume).toBeLessThanOrEqual(0)
+			expect(() => { SoundMixer.volumeScale = "log" as never }).toThrow()
+		} finally {
+			SoundMixer.volumeScale = "linear"
+		}
+	})
+
+	linuxIt("should set and clear session rules", () => {
+		expect(SoundMixer.setRules([
+			{ match: { binary: /firefox/i, role: "music" }, maxVolume: 0.5 },
+			{ match: { appName: "Softphone" }, volume: 1, mute: false },
+		])).toBe(true)
+		expect(SoundMixer.setRules([])).toBe(true)
+	})
+
+	linuxIt("should apply a rule to a new session", async () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER)
+		// 1 s of silence, long enough to find the stream playing it
+		const pcm = new Int16Array(2 * 48000)
+		expect(SoundMixer.uploadSample("sound-mixer-rule", pcm)).toBe(true)
+		try {
+			// samples are played by the server for the client uploading them
+			expect(SoundMixer.setRules([
+				{ match: { appName: "sound-mixer" }, volume: .25 },
+			])).toBe(true)
+			expect(device.playSample("sound-mixer-rule", 1)).toBe(true)
+			await new Promise((resolve) => setTimeout(resolve, 200))
+			const session = device.sessions
+				.find(({ name }) => name === "sound-mixer-rule")
+			expect(session).toBeDefined()
+			expect(session.volume).toBeCloseTo(.25, 2)
+		} finally {
+			SoundMixer.setRules([])
+			SoundMixer.removeSample("sound-mixer-rule")
+		}
+	})
+
+	linuxIt("should move a relative group proportionally", () => {
+		const devices = SoundMixer.devices
+			.filter(({ type }) => type === DeviceType.RENDER)
+		const original = devices.map(({ volume }) => volume)
+		try {
+			devices.forEach((device, i) => { device.volume = i ? .4 : .8 })
+			const group = SoundMixer.createGroup(devices, { mode: "relative" })
+			expect(group.mode).toBe("relative")
+			expect(group.volume).toBeCloseTo(.8, 2)
+			group.volume = .4
+			expect(devices[0].volume).toBeCloseTo(.4, 2)
+			devices.slice(1)
+				.forEach((device) => expect(device.volume).toBeCloseTo(.2, 2))
+		} finally {
+			devices.forEach((device, i) => { device.volume = original[i] })
+		}
+	})
+
+	linuxIt("should reject invalid group members", () => {
+		expect(() => SoundMixer.createGroup([{} as Device])).toThrow()
+		expect(() => SoundMixer.createGroup([], { mode: "linked" } as never))
+			.toThrow()
+	})
+
+	linuxIt("should start and stop ducking", () => {
+		const handler = SoundMixer.duck({ appName: /softphone/i },
+			{ appName: /spotify|rhythmbox/i },
+			{ depth: 18, attackMs: 20, releaseMs: 800 })
+		expect(handler).toBeGreaterThanOrEqual(0)
+		expect(SoundMixer.stopDucking(handler)).toBe(true)
+		expect(SoundMixer.stopDucking(handler)).toBe(false)
+		expect(() => SoundMixer.duck({}, {}, { depth: 0 })).toThrow()
+	})
+
+	linuxIt("should duck a target while the trigger plays", async () => {
+		const device = SoundMixer.getDefaultDevice(DeviceType.RENDER)
+		// 1 s of silence each, the sessions are named after the samples
+		const pcm = new Int16Array(2 * 48000)
+		expect(SoundMixer.uploadSample("sound-mixer-target", pcm)).toBe(true)
+		expect(SoundMixer.uploadSample("sound-mixer-trigger", pcm)).toBe(true)
+		let handler = -1
+		try {
+			expect(device.playSample("sound-mixer-target", 1)).toBe(true)
+			await new Promise((resolve) => setTimeout(resolve, 100))
+			const target = device.sessions
+				.find(({ name }) => name === "sound-mixer-target")
+			expect(target).toBeDefined()
+			const original = target.volume
+
+			handler = SoundMixer.duck({ name: "sound-mixer-trigger" },
+				{ name: "sound-mixer-target" },
+				{ depth: 18, attackMs: 20, releaseMs: 20 })
+			expect(handler).toBeGreaterThanOrEqual(0)
+			expect(device.playSample("sound-mixer-trigger", 1)).toBe(true)
+			await new Promise((resolve) => setTimeout(resolve, 200))
+			expect(target.volume).toBeLessThan(original)
+		} finally {
+			SoundMixer.stopDucking(handler)
+			SoundMixer.removeSample("sound-mixer-target")
+			SoundMixer.removeSample("sound-mixer-trigger")
+		}
+	})
+
+	linuxIt("should reject an invalid rule", () => {
+		expect(() => SoundMixer.setRules([{ volume: 2 }])).toThrow()
+		expect(() => SoundMixer.setRules([{ mute: "yes" } as never])).toThrow()
+	})
+
 })